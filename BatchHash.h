@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Integer hasher with a batch kernel. Scalar calls and batches give identical
+// results: the murmur3 finaliser, whose low bits are well mixed, which the
+// tables need since they reduce hashes by mask or modulo.
+//
+// With AVX2 enabled at compile time (-mavx2 or /arch:AVX2) hash_batch() mixes
+// four keys per instruction; AVX2 has no 64-bit multiply, so each one is built
+// from three 32x32 multiplies. Otherwise it is a plain loop.
+template<typename Key>
+struct MultiplyShiftHash
+{
+	static_assert(std::is_integral_v<Key> || std::is_enum_v<Key>, "MultiplyShiftHash needs an integral or enum key");
+
+	static constexpr std::uint64_t multiplier1 = 0xFF51AFD7ED558CCDull;
+	static constexpr std::uint64_t multiplier2 = 0xC4CEB9FE1A85EC53ull;
+
+	static constexpr std::uint64_t widen(const Key& key) noexcept
+	{
+		if constexpr (std::is_enum_v<Key>)
+			return static_cast<std::uint64_t>(static_cast<std::underlying_type_t<Key>>(key));
+		else
+			return static_cast<std::uint64_t>(key);
+	}
+
+	static constexpr std::uint64_t mix(std::uint64_t x) noexcept
+	{
+		x ^= x >> 33;
+		x *= multiplier1;
+		x ^= x >> 33;
+		x *= multiplier2;
+		x ^= x >> 33;
+		return x;
+	}
+
+	constexpr std::size_t operator()(const Key& key) const noexcept
+	{
+		return static_cast<std::size_t>(mix(widen(key)));
+	}
+
+	void hash_batch(const Key* keys, std::size_t count, std::size_t* hashes) const noexcept
+	{
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		if constexpr (sizeof(std::size_t) == 8 && !std::is_enum_v<Key> && (sizeof(Key) == 8 || sizeof(Key) == 4))
+		{
+			for (; i + 4 <= count; i += 4)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + i), mix4(load4(keys + i)));
+		}
+#endif
+		for (; i < count; ++i)
+			hashes[i] = (*this)(keys[i]);
+	}
+
+#if defined(__AVX2__)
+private:
+	// Loads four keys widened to 64-bit lanes the same way widen() does.
+	static __m256i load4(const Key* keys) noexcept
+	{
+		if constexpr (sizeof(Key) == 8)
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+		else if constexpr (std::is_signed_v<Key>)
+			return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+		else
+			return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+	}
+
+	// Low 64 bits of x * c per lane: lo*lo + ((hi*lo + lo*hi) << 32).
+	static __m256i multiply4(__m256i x, std::uint64_t c) noexcept
+	{
+		const __m256i c_low = _mm256_set1_epi64x(static_cast<long long>(c & 0xFFFFFFFFull));
+		const __m256i c_high = _mm256_set1_epi64x(static_cast<long long>(c >> 32));
+		const __m256i low = _mm256_mul_epu32(x, c_low);
+		const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), c_low), _mm256_mul_epu32(x, c_high));
+		return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+	}
+
+	static __m256i mix4(__m256i x) noexcept
+	{
+		x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+		x = multiply4(x, multiplier1);
+		x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+		x = multiply4(x, multiplier2);
+		x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+		return x;
+	}
+#endif
+};
+
+template<typename Hash, typename Key, typename = void>
+struct has_hash_batch : std::false_type {};
+
+template<typename Hash, typename Key>
+struct has_hash_batch<Hash, Key, std::void_t<decltype(std::declval<const Hash&>().hash_batch(
+	std::declval<const Key*>(), std::size_t(), std::declval<std::size_t*>()))>> : std::true_type {};
+
+// Hashes count keys into hashes, through the hasher's batch kernel if it has one.
+template<typename Hash, typename Key>
+inline void hash_keys(const Hash& hash, const Key* keys, std::size_t count, std::size_t* hashes)
+{
+	if constexpr (has_hash_batch<Hash, Key>::value)
+		hash.hash_batch(keys, count, hashes);
+	else
+		for (std::size_t i = 0; i < count; ++i)
+			hashes[i] = hash(keys[i]);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <new>
 #include <cstddef>
 #include <utility>
 #include <type_traits>
@@ -115,3 +116,86 @@ private:
             ptr()->~value_type();
     }
 };
+
+
+template<typename Key>
+class KeyBucket
+{
+private:
+    BucketState _state = BucketState::EMPTY;
+    alignas(Key) unsigned char _storage[sizeof(Key)];
+
+    Key* ptr() noexcept
+    {
+        return std::launder(reinterpret_cast<Key*>(&_storage));
+    }
+
+    const Key* ptr() const noexcept
+    {
+        return std::launder(reinterpret_cast<const Key*>(&_storage));
+    }
+
+public:
+    KeyBucket() noexcept
+        : _state(BucketState::EMPTY)
+    {
+    }
+
+    ~KeyBucket()
+    {
+        destroy_key();
+    }
+
+    KeyBucket(const KeyBucket&) = delete;
+    KeyBucket& operator=(const KeyBucket&) = delete;
+
+    template<typename... Args>
+    void make_occupied(Args&&... args)
+    {
+        destroy_key();
+        new (&_storage) Key(std::forward<Args>(args)...);
+        _state = BucketState::OCCUPIED;
+    }
+
+    void make_empty() noexcept
+    {
+        destroy_key();
+        _state = BucketState::EMPTY;
+    }
+
+    void make_deleted() noexcept
+    {
+        destroy_key();
+        _state = BucketState::DELETED;
+    }
+
+    [[nodiscard]] bool is_empty() const noexcept { return _state == BucketState::EMPTY; }
+    [[nodiscard]] bool is_occupied() const noexcept { return _state == BucketState::OCCUPIED; }
+    [[nodiscard]] bool is_deleted() const noexcept { return _state == BucketState::DELETED; }
+
+    [[nodiscard]] BucketState state() const noexcept { return _state; }
+
+    Key& key() noexcept { return *ptr(); }
+    const Key& key() const noexcept { return *ptr(); }
+
+private:
+    void destroy_key() noexcept
+    {
+        if (_state == BucketState::OCCUPIED)
+            ptr()->~Key();
+    }
+};
+// Whether a rehash moves elements out of the old slots. Elements are moved when
+// neither the key nor the value can throw on move (or one of them cannot be copied),
+// and copied otherwise, so a rehash that fails part-way can put them all back.
+template<typename Key, typename T>
+inline constexpr bool relocate_by_move_v =
+    (std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<T>)
+    || !std::is_copy_constructible_v<Key> || !std::is_copy_constructible_v<T>;
+
+// Source for relocating one half of an element, per relocate_by_move_v.
+template<bool Move, typename U>
+constexpr std::conditional_t<Move, U&&, const U&> relocation_source(U& value) noexcept
+{
+    return static_cast<std::conditional_t<Move, U&&, const U&>>(value);
+}
@@ -0,0 +1,982 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <functional>
+
+#include "Bucket.h"
+#include "MemoryUsage.h"
+
+// Slots are grouped into 64-byte-aligned lines, each headed by an occupancy mask,
+// a tombstone mask and one tag byte per slot holding the top bits of the slot's
+// mixed hash. A probe scans every slot of its home line, comparing tags before keys,
+// and only moves on to the next line when the home line is full; a lookup stops
+// at the first line that still has a never-used slot. For small keys and values
+// the common case is exactly one cache line per lookup, without SIMD control bytes.
+//
+// Lines are probed linearly, so there is no pluggable strategy. The line count is
+// a power of two. The line and the tag both come from a mixed hash, since
+// std::hash of an integer is often the identity and would give small keys tag 0.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>
+>
+class BucketizedHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using value_type = std::pair<const Key, T>;
+
+private:
+	using mask_type = std::uint16_t;
+
+	template<size_type Slots>
+	struct alignas(64) Line
+	{
+		mask_type occupied = 0;
+		mask_type deleted = 0;
+		std::uint8_t tags[Slots] = {};
+		alignas(Key) unsigned char keys[Slots * sizeof(Key)];
+		alignas(T) unsigned char values[Slots * sizeof(T)];
+	};
+
+	// Most slots that still fit one cache line, at least one and at most the
+	// width of the masks.
+	template<size_type Slots>
+	static constexpr size_type fit_slots() noexcept
+	{
+		if constexpr (Slots <= 1)
+			return 1;
+		else if constexpr (sizeof(Line<Slots>) <= 64)
+			return Slots;
+		else
+			return fit_slots<Slots - 1>();
+	}
+
+public:
+	static constexpr size_type slots_per_line = fit_slots<sizeof(mask_type) * 8>();
+
+private:
+	using line_type = Line<slots_per_line>;
+
+	static constexpr mask_type full_mask = static_cast<mask_type>((std::uint32_t(1) << slots_per_line) - 1);
+
+	std::unique_ptr<line_type[]> _lines;
+	size_type _line_count = 0;
+	size_type _size = 0;
+	size_type _tombstones = 0;
+	float _max_load_factor = 0.875f;
+
+	hasher _hash;
+	key_equal _equal;
+
+public:
+	template<bool IsConst>
+	class HashIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::pair<const Key, T>;
+		using reference = std::pair<const Key&, std::conditional_t<IsConst, const T&, T&>>;
+
+		struct pointer
+		{
+			reference ref;
+			reference* operator->() { return &ref; }
+		};
+
+	private:
+		using table_ptr = std::conditional_t<IsConst, const BucketizedHashTable*, BucketizedHashTable*>;
+
+		table_ptr _table;
+		size_type _index;
+
+		void skip_to_valid();
+
+	public:
+		HashIterator();
+		HashIterator(table_ptr table, size_type index);
+
+		reference operator*() const;
+		pointer operator->() const;
+
+		HashIterator& operator++();
+		HashIterator operator++(int);
+
+		bool operator==(const HashIterator& rhs) const;
+		bool operator!=(const HashIterator& rhs) const;
+	};
+
+	using iterator = HashIterator<false>;
+	using const_iterator = HashIterator<true>;
+
+
+	BucketizedHashTable(size_type capacity = 16);
+	BucketizedHashTable(size_type capacity, const hasher& hash, const key_equal& equal);
+	BucketizedHashTable(const BucketizedHashTable& other);
+	BucketizedHashTable(BucketizedHashTable&& other) noexcept;
+	~BucketizedHashTable();
+
+	BucketizedHashTable& operator=(const BucketizedHashTable& other);
+	BucketizedHashTable& operator=(BucketizedHashTable&& other) noexcept;
+
+	std::pair<iterator, bool> insert(const value_type& kv);
+	std::pair<iterator, bool> insert(const key_type& key, const mapped_type& value);
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args);
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj);
+
+	size_type erase(const key_type& key);
+
+	void clear();
+
+	mapped_type& operator[](const key_type& key);
+
+	mapped_type& at(const key_type& key);
+	const mapped_type& at(const key_type& key) const;
+
+	iterator find(const key_type& key);
+	const_iterator find(const key_type& key) const;
+
+	bool contains(const key_type& key) const;
+	size_type count(const key_type& key) const;
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+
+	size_type capacity() const noexcept;
+
+	float load_factor() const noexcept;
+	float max_load_factor() const noexcept;
+	void max_load_factor(float ml);
+	void reserve(size_type n);
+	void rehash(size_type new_capacity);
+
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
+
+	void swap(BucketizedHashTable& other) noexcept;
+
+	bool operator==(const BucketizedHashTable& other) const;
+	bool operator!=(const BucketizedHashTable& other) const;
+
+private:
+	static std::uint64_t mix(size_type hash) noexcept;
+	static std::uint8_t tag_of(size_type hash) noexcept;
+	size_type line_of(size_type hash) const noexcept;
+	bool is_occupied(size_type index) const noexcept;
+	key_type* key_ptr(size_type index) noexcept;
+	const key_type* key_ptr(size_type index) const noexcept;
+	mapped_type* value_ptr(size_type index) noexcept;
+	const mapped_type* value_ptr(size_type index) const noexcept;
+
+	size_type find_index(const key_type& key) const;
+	// Slot holding key, else the first free slot on its path, else capacity().
+	std::pair<size_type, bool> probe_insert_slot(const key_type& key, size_type hash_value);
+	void check_load_and_rehash();
+	// Rehashes into new_capacity slots, or returns false with the table unchanged
+	// when some key finds no free slot.
+	bool rehash_into(size_type new_capacity);
+	template<typename KeyArg, typename... Args>
+	void construct_at(size_type index, std::uint8_t tag, KeyArg&& key, Args&&... args);
+	void destroy_at(size_type index) noexcept;
+	void allocate_storage(size_type n);
+	void destroy_storage() noexcept;
+	void copy_from(const BucketizedHashTable& other);
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::skip_to_valid()
+{
+	const size_type capacity = _table->capacity();
+	while (_index < capacity && !_table->is_occupied(_index))
+		++_index;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::HashIterator()
+	: _table(nullptr)
+	, _index(0)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::HashIterator(table_ptr table, size_type index)
+	: _table(table)
+	, _index(index)
+{
+	skip_to_valid();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::template HashIterator<IsConst>::reference
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::operator*() const
+{
+	return reference(*_table->key_ptr(_index), *_table->value_ptr(_index));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::template HashIterator<IsConst>::pointer
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::operator->() const
+{
+	return pointer{ **this };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::template HashIterator<IsConst>&
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::operator++()
+{
+	++_index;
+	skip_to_valid();
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::template HashIterator<IsConst>
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::operator++(int)
+{
+	HashIterator temp = *this;
+	++(*this);
+	return temp;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+inline bool BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::operator==(const HashIterator& rhs) const
+{
+	return _table == rhs._table && _index == rhs._index;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<bool IsConst>
+inline bool BucketizedHashTable<Key, T, Hash, KeyEqual>::HashIterator<IsConst>::operator!=(const HashIterator& rhs) const
+{
+	return !(*this == rhs);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline std::uint64_t BucketizedHashTable<Key, T, Hash, KeyEqual>::mix(size_type hash) noexcept
+{
+	return static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline std::uint8_t BucketizedHashTable<Key, T, Hash, KeyEqual>::tag_of(size_type hash) noexcept
+{
+	// The line takes bits from 32 up, so the tag takes the top byte.
+	return static_cast<std::uint8_t>(mix(hash) >> 56);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::line_of(size_type hash) const noexcept
+{
+	return static_cast<size_type>(mix(hash) >> 32) & (_line_count - 1);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline bool BucketizedHashTable<Key, T, Hash, KeyEqual>::is_occupied(size_type index) const noexcept
+{
+	return (_lines[index / slots_per_line].occupied >> (index % slots_per_line)) & 1u;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline typename BucketizedHashTable<Key, T, Hash, KeyEqual>::key_type*
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::key_ptr(size_type index) noexcept
+{
+	return std::launder(reinterpret_cast<key_type*>(_lines[index / slots_per_line].keys) + index % slots_per_line);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline const typename BucketizedHashTable<Key, T, Hash, KeyEqual>::key_type*
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::key_ptr(size_type index) const noexcept
+{
+	return std::launder(reinterpret_cast<const key_type*>(_lines[index / slots_per_line].keys) + index % slots_per_line);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline typename BucketizedHashTable<Key, T, Hash, KeyEqual>::mapped_type*
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::value_ptr(size_type index) noexcept
+{
+	return std::launder(reinterpret_cast<mapped_type*>(_lines[index / slots_per_line].values) + index % slots_per_line);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline const typename BucketizedHashTable<Key, T, Hash, KeyEqual>::mapped_type*
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::value_ptr(size_type index) const noexcept
+{
+	return std::launder(reinterpret_cast<const mapped_type*>(_lines[index / slots_per_line].values) + index % slots_per_line);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::find_index(const key_type& key) const
+{
+	if (_line_count == 0)
+		return capacity();
+
+	const size_type hash = _hash(key);
+	const std::uint8_t tag = tag_of(hash);
+	size_type line = line_of(hash);
+	for (size_type i = 0; i < _line_count; ++i, line = (line + 1) & (_line_count - 1))
+	{
+		const line_type& current = _lines[line];
+		for (size_type slot = 0; slot < slots_per_line; ++slot)
+		{
+			if (((current.occupied >> slot) & 1u) && current.tags[slot] == tag
+				&& _equal(*key_ptr(line * slots_per_line + slot), key))
+				return line * slots_per_line + slot;
+		}
+		if ((current.occupied | current.deleted) != full_mask)
+			break;
+	}
+	return capacity();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline std::pair<typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type, bool>
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::probe_insert_slot(const key_type& key, size_type hash_value)
+{
+	const size_type cap = capacity();
+	if (_line_count == 0)
+		return { cap, false };
+
+	size_type first_free = cap;
+	const std::uint8_t tag = tag_of(hash_value);
+	size_type line = line_of(hash_value);
+	for (size_type i = 0; i < _line_count; ++i, line = (line + 1) & (_line_count - 1))
+	{
+		const line_type& current = _lines[line];
+		for (size_type slot = 0; slot < slots_per_line; ++slot)
+		{
+			const bool occupied = (current.occupied >> slot) & 1u;
+			if (occupied && current.tags[slot] == tag && _equal(*key_ptr(line * slots_per_line + slot), key))
+				return { line * slots_per_line + slot, false };
+			if (!occupied && first_free == cap)
+				first_free = line * slots_per_line + slot;
+		}
+		if ((current.occupied | current.deleted) != full_mask)
+			break;
+	}
+	return { first_free, first_free != cap };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::check_load_and_rehash()
+{
+	// Tombstones keep lines looking full to lookups, so they count towards the
+	// load; when they are most of it a same-size rehash is enough.
+	const float limit = _max_load_factor * static_cast<float>(capacity());
+	if (static_cast<float>(_size + _tombstones + 1) <= limit)
+		return;
+	rehash(static_cast<float>(_size + 1) > limit / 2 ? capacity() * 2 : capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename KeyArg, typename... Args>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>
+		::construct_at(size_type index, std::uint8_t tag, KeyArg&& key, Args&&... args)
+{
+	line_type& line = _lines[index / slots_per_line];
+	const mask_type bit = static_cast<mask_type>(1u << (index % slots_per_line));
+
+	new (key_ptr(index)) key_type(std::forward<KeyArg>(key));
+	try
+	{
+		new (value_ptr(index)) mapped_type(std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		key_ptr(index)->~key_type();
+		throw;
+	}
+
+	if (line.deleted & bit)
+	{
+		line.deleted = static_cast<mask_type>(line.deleted & ~bit);
+		--_tombstones;
+	}
+	line.occupied = static_cast<mask_type>(line.occupied | bit);
+	line.tags[index % slots_per_line] = tag;
+	++_size;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::destroy_at(size_type index) noexcept
+{
+	value_ptr(index)->~mapped_type();
+	key_ptr(index)->~key_type();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::allocate_storage(size_type n)
+{
+	size_type lines = 1;
+	while (lines * slots_per_line < n)
+		lines *= 2;
+
+	_lines.reset(new line_type[lines]);
+	_line_count = lines;
+	_size = 0;
+	_tombstones = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::destroy_storage() noexcept
+{
+	for (size_type i = 0; i < capacity(); ++i)
+	{
+		if (is_occupied(i))
+			destroy_at(i);
+	}
+	_lines.reset();
+	_line_count = 0;
+	_size = 0;
+	_tombstones = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::copy_from(const BucketizedHashTable& other)
+{
+	allocate_storage(other.capacity());
+	try
+	{
+		for (size_type i = 0; i < other.capacity(); ++i)
+		{
+			if (other.is_occupied(i))
+				construct_at(i, other._lines[i / slots_per_line].tags[i % slots_per_line], *other.key_ptr(i), *other.value_ptr(i));
+		}
+	}
+	catch (...)
+	{
+		// Only elements whose occupied bit is set were fully built.
+		destroy_storage();
+		throw;
+	}
+	for (size_type line = 0; line < _line_count; ++line)
+		_lines[line].deleted = other._lines[line].deleted;
+	_tombstones = other._tombstones;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::BucketizedHashTable(size_type capacity)
+	: _hash(Hash())
+	, _equal(KeyEqual())
+{
+	allocate_storage(capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::BucketizedHashTable(size_type capacity, const hasher& hash, const key_equal& equal)
+	: _hash(hash)
+	, _equal(equal)
+{
+	allocate_storage(capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::BucketizedHashTable(const BucketizedHashTable& other)
+	: _max_load_factor(other._max_load_factor)
+	, _hash(other._hash)
+	, _equal(other._equal)
+{
+	copy_from(other);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::BucketizedHashTable(BucketizedHashTable&& other) noexcept
+	: _lines(std::move(other._lines))
+	, _line_count(other._line_count)
+	, _size(other._size)
+	, _tombstones(other._tombstones)
+	, _max_load_factor(other._max_load_factor)
+	, _hash(std::move(other._hash))
+	, _equal(std::move(other._equal))
+{
+	other._line_count = 0;
+	other._size = 0;
+	other._tombstones = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>::~BucketizedHashTable()
+{
+	destroy_storage();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>&
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::operator=(const BucketizedHashTable& other)
+{
+	if (this != &other)
+	{
+		destroy_storage();
+
+		_hash = other._hash;
+		_equal = other._equal;
+		_max_load_factor = other._max_load_factor;
+		copy_from(other);
+	}
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketizedHashTable<Key, T, Hash, KeyEqual>&
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::operator=(BucketizedHashTable&& other) noexcept
+{
+	if (this != &other)
+	{
+		destroy_storage();
+
+		_lines = std::move(other._lines);
+		_line_count = other._line_count;
+		_size = other._size;
+		_tombstones = other._tombstones;
+		_hash = std::move(other._hash);
+		_equal = std::move(other._equal);
+		_max_load_factor = other._max_load_factor;
+
+		other._line_count = 0;
+		other._size = 0;
+		other._tombstones = 0;
+	}
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+std::pair<typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator, bool>
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::insert(const value_type& kv)
+{
+	return try_emplace(kv.first, kv.second);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+std::pair<typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator, bool>
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::insert(const key_type& key, const mapped_type& value)
+{
+	return try_emplace(key, value);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename... Args>
+inline std::pair<typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator, bool>
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::try_emplace(const key_type& key, Args&&... args)
+{
+	check_load_and_rehash();
+
+	const size_type hash = _hash(key);
+	auto [index, inserted] = probe_insert_slot(key, hash);
+	if (index == capacity())
+		return { end(), false };
+
+	if (inserted)
+		construct_at(index, tag_of(hash), key, std::forward<Args>(args)...);
+
+	return { iterator(this, index), inserted };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename M>
+inline std::pair<typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator, bool>
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::insert_or_assign(const key_type& key, M&& obj)
+{
+	check_load_and_rehash();
+
+	const size_type hash = _hash(key);
+	auto [index, inserted] = probe_insert_slot(key, hash);
+	if (index == capacity())
+		return { end(), false };
+
+	if (inserted)
+		construct_at(index, tag_of(hash), key, std::forward<M>(obj));
+	else
+		*value_ptr(index) = std::forward<M>(obj);
+
+	return { iterator(this, index), inserted };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::erase(const key_type& key)
+{
+	size_type index = find_index(key);
+	if (index == capacity())
+		return 0;
+
+	destroy_at(index);
+	line_type& line = _lines[index / slots_per_line];
+	const mask_type bit = static_cast<mask_type>(1u << (index % slots_per_line));
+	line.occupied = static_cast<mask_type>(line.occupied & ~bit);
+	// A line with a never-used slot ends every probe through it, so its slots
+	// can be freed outright instead of left as tombstones.
+	if ((line.occupied | line.deleted | bit) == full_mask)
+	{
+		line.deleted = static_cast<mask_type>(line.deleted | bit);
+		++_tombstones;
+	}
+	--_size;
+	return 1;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void BucketizedHashTable<Key, T, Hash, KeyEqual>::clear()
+{
+	for (size_type i = 0; i < capacity(); ++i)
+	{
+		if (is_occupied(i))
+			destroy_at(i);
+	}
+	for (size_type line = 0; line < _line_count; ++line)
+	{
+		_lines[line].occupied = 0;
+		_lines[line].deleted = 0;
+	}
+	_size = 0;
+	_tombstones = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::mapped_type&
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::operator[](const key_type& key)
+{
+	check_load_and_rehash();
+
+	const size_type hash = _hash(key);
+	auto [index, inserted] = probe_insert_slot(key, hash);
+	if (index == capacity())
+	{
+		rehash(capacity() * 2);
+		return (*this)[key];
+	}
+
+	if (inserted)
+		construct_at(index, tag_of(hash), key);
+	return *value_ptr(index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::mapped_type&
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::at(const key_type& key)
+{
+	size_type index = find_index(key);
+	if (index == capacity())
+		throw std::out_of_range("Key not found");
+	return *value_ptr(index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+const typename BucketizedHashTable<Key, T, Hash, KeyEqual>::mapped_type&
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::at(const key_type& key) const
+{
+	size_type index = find_index(key);
+	if (index == capacity())
+		throw std::out_of_range("Key not found");
+	return *value_ptr(index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::find(const key_type& key)
+{
+	size_type index = find_index(key);
+	return index == capacity() ? end() : iterator(this, index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::const_iterator
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::find(const key_type& key) const
+{
+	size_type index = find_index(key);
+	return index == capacity() ? cend() : const_iterator(this, index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool BucketizedHashTable<Key, T, Hash, KeyEqual>::contains(const key_type& key) const
+{
+	return find_index(key) != capacity();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::count(const key_type& key) const
+{
+	return contains(key) ? 1 : 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::size() const noexcept
+{
+	return _size;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool BucketizedHashTable<Key, T, Hash, KeyEqual>::empty() const noexcept
+{
+	return _size == 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::size_type
+		BucketizedHashTable<Key, T, Hash, KeyEqual>::capacity() const noexcept
+{
+	return _line_count * slots_per_line;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+float BucketizedHashTable<Key, T, Hash, KeyEqual>::load_factor() const noexcept
+{
+	return capacity() == 0 ? 0.0f : static_cast<float>(_size) / static_cast<float>(capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+float BucketizedHashTable<Key, T, Hash, KeyEqual>::max_load_factor() const noexcept
+{
+	return _max_load_factor;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void BucketizedHashTable<Key, T, Hash, KeyEqual>::max_load_factor(float ml)
+{
+	if (ml <= 0.0f || ml > 1.0f)
+		throw std::invalid_argument("max_load_factor must be in (0, 1]");
+	_max_load_factor = ml;
+	if (load_factor() > _max_load_factor)
+		rehash(capacity() * 2);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void BucketizedHashTable<Key, T, Hash, KeyEqual>::reserve(size_type n)
+{
+	const size_type needed = static_cast<size_type>(static_cast<float>(n) / _max_load_factor) + 1;
+	if (needed > capacity())
+		rehash(needed);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void BucketizedHashTable<Key, T, Hash, KeyEqual>::rehash(size_type new_capacity)
+{
+	if (static_cast<float>(new_capacity) * _max_load_factor < static_cast<float>(_size))
+		new_capacity = static_cast<size_type>(static_cast<float>(_size) / _max_load_factor) + 1;
+
+	while (!rehash_into(new_capacity))
+		new_capacity = new_capacity == 0 ? 16 : new_capacity * 2;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool BucketizedHashTable<Key, T, Hash, KeyEqual>::rehash_into(size_type new_capacity)
+{
+	// See SplitOpenAddressingHashTable::rehash_into().
+	constexpr bool move = relocate_by_move_v<Key, T>;
+	constexpr bool move_back = std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<T>;
+
+	std::vector<size_type> placed;
+	placed.reserve(_size);
+
+	std::unique_ptr<line_type[]> old_lines = std::move(_lines);
+	const size_type old_line_count = _line_count;
+	const size_type old_size = _size;
+	const size_type old_tombstones = _tombstones;
+	auto old_key = [&old_lines](size_type i) {
+		return std::launder(reinterpret_cast<key_type*>(old_lines[i / slots_per_line].keys) + i % slots_per_line);
+	};
+	auto old_value = [&old_lines](size_type i) {
+		return std::launder(reinterpret_cast<mapped_type*>(old_lines[i / slots_per_line].values) + i % slots_per_line);
+	};
+	auto old_occupied = [&old_lines](size_type i) {
+		return ((old_lines[i / slots_per_line].occupied >> (i % slots_per_line)) & 1u) != 0;
+	};
+
+	auto restore = [&]() noexcept {
+		size_type next = 0;
+		for (size_type i = 0; i < old_line_count * slots_per_line && next < placed.size(); ++i)
+		{
+			if (!old_occupied(i))
+				continue;
+			const size_type index = placed[next++];
+			if constexpr (move_back)
+			{
+				old_key(i)->~key_type();
+				new (old_key(i)) key_type(std::move(*key_ptr(index)));
+				old_value(i)->~mapped_type();
+				new (old_value(i)) mapped_type(std::move(*value_ptr(index)));
+			}
+			destroy_at(index);
+		}
+		_lines = std::move(old_lines);
+		_line_count = old_line_count;
+		_size = old_size;
+		_tombstones = old_tombstones;
+	};
+
+	try
+	{
+		allocate_storage(new_capacity);
+
+		for (size_type i = 0; i < old_line_count * slots_per_line; ++i)
+		{
+			if (!old_occupied(i))
+				continue;
+
+			key_type& key = *old_key(i);
+			const size_type hash = _hash(key);
+			auto [index, inserted] = probe_insert_slot(key, hash);
+			if (!inserted)
+			{
+				restore();
+				return false;
+			}
+			construct_at(index, tag_of(hash), relocation_source<move>(key), relocation_source<move>(*old_value(i)));
+			placed.push_back(index);
+		}
+	}
+	catch (...)
+	{
+		restore();
+		throw;
+	}
+
+	for (size_type i = 0; i < old_line_count * slots_per_line; ++i)
+	{
+		if (old_occupied(i))
+		{
+			old_value(i)->~mapped_type();
+			old_key(i)->~key_type();
+		}
+	}
+	return true;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+MemoryUsage BucketizedHashTable<Key, T, Hash, KeyEqual>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename Sizer>
+MemoryUsage BucketizedHashTable<Key, T, Hash, KeyEqual>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage;
+	usage.object_bytes = sizeof(*this);
+	usage.slot_bytes = capacity() * (sizeof(key_type) + sizeof(mapped_type));
+	// Masks, tags and the padding that rounds each line to a cache line.
+	usage.metadata_bytes = _line_count * sizeof(line_type) - usage.slot_bytes;
+
+	for (size_type i = 0; i < capacity(); ++i)
+	{
+		if (is_occupied(i))
+			usage.external_bytes += sizer(*key_ptr(i), *value_ptr(i));
+	}
+	usage.payload_bytes = _size * (sizeof(key_type) + sizeof(mapped_type)) + usage.external_bytes;
+	return usage;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator BucketizedHashTable<Key, T, Hash, KeyEqual>::begin()
+{
+	return iterator(this, 0);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::iterator BucketizedHashTable<Key, T, Hash, KeyEqual>::end()
+{
+	return iterator(this, capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::const_iterator BucketizedHashTable<Key, T, Hash, KeyEqual>::begin() const
+{
+	return const_iterator(this, 0);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::const_iterator BucketizedHashTable<Key, T, Hash, KeyEqual>::end() const
+{
+	return const_iterator(this, capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::const_iterator BucketizedHashTable<Key, T, Hash, KeyEqual>::cbegin() const
+{
+	return const_iterator(this, 0);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename BucketizedHashTable<Key, T, Hash, KeyEqual>::const_iterator BucketizedHashTable<Key, T, Hash, KeyEqual>::cend() const
+{
+	return const_iterator(this, capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void BucketizedHashTable<Key, T, Hash, KeyEqual>::swap(BucketizedHashTable& other) noexcept
+{
+	std::swap(_lines, other._lines);
+	std::swap(_line_count, other._line_count);
+	std::swap(_size, other._size);
+	std::swap(_tombstones, other._tombstones);
+	std::swap(_max_load_factor, other._max_load_factor);
+	std::swap(_hash, other._hash);
+	std::swap(_equal, other._equal);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline bool BucketizedHashTable<Key, T, Hash, KeyEqual>::operator==(const BucketizedHashTable& other) const
+{
+	if (_size != other._size)
+		return false;
+
+	for (size_type i = 0; i < capacity(); ++i)
+	{
+		if (!is_occupied(i))
+			continue;
+
+		size_type index = other.find_index(*key_ptr(i));
+		if (index == other.capacity() || !(*other.value_ptr(index) == *value_ptr(i)))
+			return false;
+	}
+	return true;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline bool BucketizedHashTable<Key, T, Hash, KeyEqual>::operator!=(const BucketizedHashTable& other) const
+{
+	return !(*this == other);
+}
+
+template<typename K, typename M, typename H, typename E>
+inline void swap(BucketizedHashTable<K, M, H, E>& lhs, BucketizedHashTable<K, M, H, E>& rhs) noexcept
+{
+	lhs.swap(rhs);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <initializer_list>
+
+// std::hash is not constexpr, so constant-evaluated tables hash with this instead.
+template<typename Key>
+struct ConstexprHash
+{
+	constexpr std::size_t operator()(const Key& key) const noexcept
+	{
+		static_assert(std::is_integral_v<Key> || std::is_enum_v<Key>, "ConstexprHash needs an integral, enum or string_view key");
+
+		std::uint64_t x = 0;
+		if constexpr (std::is_enum_v<Key>)
+			x = static_cast<std::uint64_t>(static_cast<std::underlying_type_t<Key>>(key));
+		else
+			x = static_cast<std::uint64_t>(key);
+
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBull;
+		x ^= x >> 31;
+		return static_cast<std::size_t>(x);
+	}
+};
+
+template<>
+struct ConstexprHash<std::string_view>
+{
+	constexpr std::size_t operator()(std::string_view key) const noexcept
+	{
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		for (char c : key)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001B3ull;
+		}
+		return static_cast<std::size_t>(hash);
+	}
+};
+
+// Fixed-capacity linear-probing table of literal types that can be built and
+// queried in constant expressions, so a constexpr instance lives in read-only data
+// with no startup cost. Exceeding the capacity throws (a compile error when
+// constant-evaluated).
+template<
+	typename Key,
+	typename T,
+	std::size_t N,
+	typename Hash = ConstexprHash<Key>,
+	typename KeyEqual = std::equal_to<Key>
+>
+class ConstexprHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using value_type = std::pair<Key, T>;
+
+	static_assert(N > 0, "ConstexprHashTable needs a non-zero capacity");
+
+private:
+	Key _keys[N] = {};
+	T _values[N] = {};
+	bool _occupied[N] = {};
+	size_type _size = 0;
+
+public:
+	constexpr ConstexprHashTable() = default;
+
+	constexpr ConstexprHashTable(std::initializer_list<value_type> init)
+	{
+		for (const auto& elem : init)
+			insert(elem.first, elem.second);
+	}
+
+	constexpr bool insert(const key_type& key, const mapped_type& value)
+	{
+		const size_type index = probe(key);
+		if (index == N)
+			throw std::length_error("ConstexprHashTable capacity exceeded");
+		if (_occupied[index])
+			return false;
+
+		_keys[index] = key;
+		_values[index] = value;
+		_occupied[index] = true;
+		++_size;
+		return true;
+	}
+
+	constexpr const mapped_type* find(const key_type& key) const
+	{
+		const size_type index = probe(key);
+		return index != N && _occupied[index] ? &_values[index] : nullptr;
+	}
+
+	constexpr const mapped_type& at(const key_type& key) const
+	{
+		const mapped_type* value = find(key);
+		if (value == nullptr)
+			throw std::out_of_range("Key not found");
+		return *value;
+	}
+
+	constexpr bool contains(const key_type& key) const
+	{
+		return find(key) != nullptr;
+	}
+
+	constexpr size_type size() const noexcept { return _size; }
+	constexpr bool empty() const noexcept { return _size == 0; }
+	constexpr size_type capacity() const noexcept { return N; }
+
+private:
+	// Slot holding key, else the first free slot on its probe path, else N.
+	constexpr size_type probe(const key_type& key) const
+	{
+		size_type index = Hash{}(key) % N;
+		for (size_type i = 0; i < N; ++i)
+		{
+			if (!_occupied[index] || KeyEqual{}(_keys[index], key))
+				return index;
+			index = index + 1 == N ? 0 : index + 1;
+		}
+		return N;
+	}
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ProbingStrategy.h"
+#include "FastModulo.h"
 #include <functional>
 
 template<typename Key>
@@ -8,17 +9,25 @@ class DoubleHashing : public IProbingStrategy<Key>
 {
 private:
 	std::size_t _secondary_prime;
+	FastModulo _secondary_modulo;
+	FastModulo _modulo;
 
 public:
 	explicit DoubleHashing(std::size_t secondary_prime = 97)
 		: _secondary_prime(secondary_prime)
+		, _secondary_modulo(secondary_prime)
 	{
 	}
 
 	std::size_t probe(const Key& key, std::size_t hash, std::size_t attempt, std::size_t capacity) const override
 	{
-		std::size_t hash2 = _secondary_prime - (std::hash<Key>{}(key) % _secondary_prime);
-		return (hash + attempt * hash2) % capacity;
+		std::size_t hash2 = _secondary_prime - _secondary_modulo(std::hash<Key>{}(key));
+		return _modulo.reduce(hash + attempt * hash2, capacity);
+	}
+
+	void set_capacity(std::size_t capacity) override
+	{
+		_modulo = FastModulo(capacity);
 	}
 
 	IProbingStrategy<Key>* clone() const override
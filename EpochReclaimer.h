@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// Epoch-based reclamation for read-mostly structures. Each reader owns a slot on
+// its own cache line and publishes the global epoch there while it reads, so
+// readers never write a line another thread reads on its fast path. Writers
+// retire objects they have unpublished; an object is freed once every reader
+// that could still see it has left its read section.
+//
+// Writers must be serialised by the caller; readers may run concurrently with
+// them and with each other.
+class EpochReclaimer
+{
+public:
+	static constexpr std::uint64_t idle = std::numeric_limits<std::uint64_t>::max();
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<std::uint64_t> epoch{ idle };
+		std::atomic<bool> in_use{ false };
+	};
+
+	struct Retired
+	{
+		std::uint64_t epoch;
+		void* object;
+		void (*deleter)(void*);
+	};
+
+	std::unique_ptr<Slot[]> _slots;
+	std::size_t _slot_count;
+	alignas(64) std::atomic<std::uint64_t> _epoch{ 1 };
+	std::vector<Retired> _retired;
+
+public:
+	explicit EpochReclaimer(std::size_t max_readers = 64)
+		: _slots(new Slot[max_readers == 0 ? 1 : max_readers])
+		, _slot_count(max_readers == 0 ? 1 : max_readers)
+	{
+	}
+
+	EpochReclaimer(const EpochReclaimer&) = delete;
+	EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+	// No reader may be active when the reclaimer is destroyed.
+	~EpochReclaimer()
+	{
+		for (const Retired& retired : _retired)
+			retired.deleter(retired.object);
+	}
+
+	std::size_t acquire_slot()
+	{
+		for (std::size_t i = 0; i < _slot_count; ++i)
+		{
+			bool expected = false;
+			if (!_slots[i].in_use.load(std::memory_order_relaxed)
+				&& _slots[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				return i;
+		}
+		throw std::length_error("EpochReclaimer reader slots exhausted");
+	}
+
+	void release_slot(std::size_t slot) noexcept
+	{
+		_slots[slot].epoch.store(idle, std::memory_order_release);
+		_slots[slot].in_use.store(false, std::memory_order_release);
+	}
+
+	// The seq_cst store orders the announcement before the reader's loads of the
+	// protected pointer, pairing with the writer's publish-then-advance in retire().
+	void enter(std::size_t slot) noexcept
+	{
+		_slots[slot].epoch.store(_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+	}
+
+	void exit(std::size_t slot) noexcept
+	{
+		_slots[slot].epoch.store(idle, std::memory_order_release);
+	}
+
+	// Call after the object has been unpublished. Readers that entered before the
+	// epoch advances may still hold it; later readers cannot reach it.
+	template<typename U>
+	void retire(U* object)
+	{
+		if (object == nullptr)
+			return;
+
+		_retired.reserve(_retired.size() + 1);
+		const std::uint64_t epoch = _epoch.fetch_add(1, std::memory_order_seq_cst);
+		_retired.push_back({ epoch, object, [](void* p) { delete static_cast<U*>(p); } });
+		reclaim();
+	}
+
+	// Frees every retired object no active reader can still hold.
+	void reclaim()
+	{
+		std::uint64_t oldest = idle;
+		for (std::size_t i = 0; i < _slot_count; ++i)
+		{
+			const std::uint64_t epoch = _slots[i].epoch.load(std::memory_order_seq_cst);
+			if (epoch < oldest)
+				oldest = epoch;
+		}
+
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < _retired.size(); ++i)
+		{
+			if (_retired[i].epoch < oldest)
+				_retired[i].deleter(_retired[i].object);
+			else
+				_retired[kept++] = _retired[i];
+		}
+		_retired.resize(kept);
+	}
+
+	std::size_t pending() const noexcept { return _retired.size(); }
+	std::size_t max_readers() const noexcept { return _slot_count; }
+};
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <functional>
+
+#include "MemoryUsage.h"
+#include "LinearProbing.h"
+#include "OpenAddressingHashTable.h"
+
+// Extendible hashing (Fagin et al.) over fixed-size OpenAddressingHashTable
+// segments. A directory of 2^global_depth entries, indexed by the top bits of a
+// mixed hash, points at segments; a segment of local depth d is shared by the
+// 2^(global_depth - d) entries that agree on its d-bit prefix. A full segment is
+// split in two on its next prefix bit, doubling the directory only when its
+// depth already equals the global depth. Growth therefore costs O(segment size)
+// per split and never rehashes the whole table.
+//
+// Once the directory reaches max_global_depth, or a segment's keys all share a
+// prefix that long, the segment is left to rehash itself like a plain table.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class ExtendibleHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using table_type = OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>;
+
+	static constexpr unsigned max_global_depth = 20;
+
+private:
+	struct Segment
+	{
+		table_type table;
+		unsigned local_depth;
+
+		Segment(size_type capacity, unsigned depth)
+			: table(capacity)
+			, local_depth(depth)
+		{
+		}
+	};
+
+	std::vector<std::unique_ptr<Segment>> _segments;
+	std::vector<Segment*> _directory;
+	unsigned _global_depth = 0;
+	size_type _segment_capacity;
+	size_type _size = 0;
+	size_type _splits = 0;
+	hasher _hash;
+
+public:
+	explicit ExtendibleHashTable(size_type segment_capacity = 4096);
+
+	ExtendibleHashTable(const ExtendibleHashTable&) = delete;
+	ExtendibleHashTable& operator=(const ExtendibleHashTable&) = delete;
+
+	bool insert(const key_type& key, const mapped_type& value);
+	bool insert_or_assign(const key_type& key, const mapped_type& value);
+
+	// The reference stays valid until the next insertion, which may split its segment,
+	// or the next erase, which may shift it within its segment.
+	mapped_type& operator[](const key_type& key);
+
+	mapped_type& at(const key_type& key);
+	const mapped_type& at(const key_type& key) const;
+
+	std::optional<mapped_type> find(const key_type& key) const;
+	bool contains(const key_type& key) const;
+	size_type erase(const key_type& key);
+	void clear();
+
+	// Calls fn(const key_type&, mapped_type&) for every element, segment by segment.
+	template<typename Fn>
+	void for_each(Fn&& fn);
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+
+	unsigned global_depth() const noexcept;
+	size_type segment_count() const noexcept;
+	size_type segment_capacity() const noexcept;
+	// Segment splits since construction.
+	size_type splits() const noexcept;
+
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+private:
+	static std::uint64_t mix(std::size_t hash) noexcept;
+	size_type directory_index(const key_type& key) const noexcept;
+	Segment& segment_for(const key_type& key) const noexcept;
+
+	// Splits the segment holding key until it has room for one more element,
+	// or until it cannot be split further. Returns the segment key now maps to.
+	Segment& make_room(const key_type& key);
+	bool is_full(const Segment& segment) const noexcept;
+	void split(Segment& segment, size_type directory_slot);
+	void double_directory();
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::ExtendibleHashTable(size_type segment_capacity)
+	: _segment_capacity(segment_capacity < 16 ? 16 : segment_capacity)
+	, _hash(Hash())
+{
+	_segments.emplace_back(new Segment(_segment_capacity, 0));
+	_directory.push_back(_segments.back().get());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline std::uint64_t ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mix(std::size_t hash) noexcept
+{
+	// Segments index by the low bits of the same hash, so the directory takes the
+	// top bits of a mixed value to keep the two independent.
+	return static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::directory_index(const key_type& key) const noexcept
+{
+	if (_global_depth == 0)
+		return 0;
+	return static_cast<size_type>(mix(_hash(key)) >> (64 - _global_depth));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Segment&
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::segment_for(const key_type& key) const noexcept
+{
+	return *_directory[directory_index(key)];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::is_full(const Segment& segment) const noexcept
+{
+	// The segment's own table grows once its load factor is exceeded; stop one
+	// element short of that so segments keep their fixed size.
+	const table_type& table = segment.table;
+	return static_cast<float>(table.size() + 1) > table.max_load_factor() * static_cast<float>(table.capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Segment&
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::make_room(const key_type& key)
+{
+	for (;;)
+	{
+		const size_type slot = directory_index(key);
+		Segment& segment = *_directory[slot];
+		if (!is_full(segment) || segment.table.contains(key) || segment.local_depth >= max_global_depth)
+			return segment;
+
+		if (segment.local_depth == _global_depth)
+			double_directory();
+		split(segment, directory_index(key));
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::double_directory()
+{
+	std::vector<Segment*> directory(_directory.size() * 2);
+	for (size_type i = 0; i < directory.size(); ++i)
+		directory[i] = _directory[i >> 1];
+	_directory.swap(directory);
+	++_global_depth;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::split(Segment& segment, size_type directory_slot)
+{
+	const unsigned depth = segment.local_depth + 1;
+	const std::uint64_t bit = std::uint64_t(1) << (63 - segment.local_depth);
+
+	// Rebuild both halves from scratch rather than erasing from the old table,
+	// which would leave it full of tombstones.
+	std::unique_ptr<Segment> high(new Segment(_segment_capacity, depth));
+	table_type low(_segment_capacity);
+	for (auto& [key, value] : segment.table)
+	{
+		table_type& target = (mix(_hash(key)) & bit) ? high->table : low;
+		target.insert(key, value);
+	}
+	segment.table = std::move(low);
+	segment.local_depth = depth;
+
+	// The 2^(global - depth + 1) entries sharing the old prefix form one aligned
+	// run; its upper half now belongs to the new segment.
+	const size_type run = size_type(1) << (_global_depth - depth + 1);
+	const size_type first = directory_slot & ~(run - 1);
+	for (size_type i = first + run / 2; i < first + run; ++i)
+		_directory[i] = high.get();
+
+	_segments.push_back(std::move(high));
+	++_splits;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(const key_type& key, const mapped_type& value)
+{
+	table_type& table = make_room(key).table;
+	auto [it, inserted] = table.insert(key, value);
+	if (it == table.end())
+	{
+		table.rehash(table.capacity() * 2);
+		std::tie(it, inserted) = table.insert(key, value);
+		if (it == table.end())
+			throw std::length_error("ExtendibleHashTable segment has no free slot");
+	}
+	_size += inserted ? 1 : 0;
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert_or_assign(const key_type& key, const mapped_type& value)
+{
+	table_type& table = make_room(key).table;
+	auto [it, inserted] = table.insert_or_assign(key, value);
+	if (it == table.end())
+	{
+		table.rehash(table.capacity() * 2);
+		std::tie(it, inserted) = table.insert_or_assign(key, value);
+		if (it == table.end())
+			throw std::length_error("ExtendibleHashTable segment has no free slot");
+	}
+	_size += inserted ? 1 : 0;
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::operator[](const key_type& key)
+{
+	table_type& table = make_room(key).table;
+	const size_type before = table.size();
+	mapped_type& value = table[key];
+	_size += table.size() - before;
+	return value;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key)
+{
+	return segment_for(key).table.at(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+const typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key) const
+{
+	return segment_for(key).table.at(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key) const
+{
+	const table_type& table = segment_for(key).table;
+	auto it = table.find(key);
+	if (it == table.end())
+		return std::nullopt;
+	return it->second;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key) const
+{
+	return segment_for(key).table.contains(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	// Segments are never merged; an emptied segment keeps its slot for reuse.
+	const size_type erased = segment_for(key).table.erase(key);
+	_size -= erased;
+	return erased;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	_segments.clear();
+	_segments.emplace_back(new Segment(_segment_capacity, 0));
+	_directory.assign(1, _segments.back().get());
+	_global_depth = 0;
+	_size = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Fn>
+void ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::for_each(Fn&& fn)
+{
+	for (const auto& segment : _segments)
+	{
+		for (auto& [key, value] : segment->table)
+			fn(key, value);
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size() const noexcept
+{
+	return _size;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::empty() const noexcept
+{
+	return _size == 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline unsigned ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::global_depth() const noexcept
+{
+	return _global_depth;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::segment_count() const noexcept
+{
+	return _segments.size();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::segment_capacity() const noexcept
+{
+	return _segment_capacity;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::splits() const noexcept
+{
+	return _splits;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+MemoryUsage ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Sizer>
+MemoryUsage ExtendibleHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage;
+	usage.object_bytes = sizeof(*this) + _segments.capacity() * sizeof(std::unique_ptr<Segment>);
+	usage.index_bytes = _directory.capacity() * sizeof(Segment*);
+	for (const auto& segment : _segments)
+	{
+		usage += segment->table.memory_usage(sizer);
+		usage.object_bytes += sizeof(Segment) - sizeof(table_type);
+	}
+	return usage;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Exact x % d without a hardware divide (Lemire, Kaser, Kurz: "Faster Remainder
+// by Direct Computation"). The reciprocal is computed once per divisor; power of
+// two divisors reduce to a mask. Without 128-bit integer support the plain
+// remainder is used.
+class FastModulo
+{
+private:
+	std::size_t _divisor = 0;
+	bool _power_of_two = false;
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 _multiplier = 0;
+#endif
+
+public:
+	FastModulo() noexcept = default;
+
+	explicit FastModulo(std::size_t divisor) noexcept
+		: _divisor(divisor)
+		, _power_of_two(divisor != 0 && (divisor & (divisor - 1)) == 0)
+	{
+#if defined(__SIZEOF_INT128__)
+		if (divisor != 0)
+			_multiplier = ~static_cast<unsigned __int128>(0) / divisor + 1;
+#endif
+	}
+
+	[[nodiscard]] std::size_t divisor() const noexcept { return _divisor; }
+
+	std::size_t operator()(std::size_t value) const noexcept
+	{
+		if (_power_of_two)
+			return value & (_divisor - 1);
+#if defined(__SIZEOF_INT128__)
+		const unsigned __int128 lowbits = _multiplier * value;
+		const unsigned __int128 bottom = ((lowbits & UINT64_MAX) * _divisor) >> 64;
+		const unsigned __int128 top = (lowbits >> 64) * _divisor;
+		return static_cast<std::size_t>((bottom + top) >> 64);
+#else
+		return value % _divisor;
+#endif
+	}
+
+	// Falls back to a plain remainder when asked about a different divisor, so a
+	// strategy whose cached capacity is stale still probes correctly.
+	std::size_t reduce(std::size_t value, std::size_t divisor) const noexcept
+	{
+		return divisor == _divisor ? (*this)(value) : value % divisor;
+	}
+};
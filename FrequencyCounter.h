@@ -0,0 +1,269 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <limits>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+#include "LinearProbing.h"
+#include "OpenAddressingHashTable.h"
+
+// Counts key occurrences in an unbounded stream with at most max_keys tracked
+// keys. Counts are exact until max_keys distinct keys have been seen. After that
+// the counter switches to Space-Saving (Metwally et al.): an unseen key takes
+// over the entry with the smallest count, inheriting that count as its error
+// bound. Any key occurring more than total() / max_keys times is then
+// guaranteed to be tracked, so top-K queries stay accurate in fixed memory.
+//
+// Entries live in a vector indexed from the table's slots; in approximate mode
+// a binary min-heap over the entries finds the one to replace in O(log n).
+template<
+	typename Key,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class FrequencyCounter
+{
+public:
+	using key_type = Key;
+	using count_type = std::uint64_t;
+	using size_type = std::size_t;
+
+	struct Entry
+	{
+		key_type key;
+		// Upper bound on the true count; count - error is a lower bound.
+		count_type count;
+		count_type error;
+	};
+
+private:
+	using entry_index = std::uint32_t;
+	using table_type = OpenAddressingHashTable<Key, entry_index, Hash, KeyEqual, ProbingStrategy>;
+
+	table_type _index;
+	std::vector<Entry> _entries;
+	// Min-heap of entry indices by count, and each entry's position in it. Both
+	// are empty while the counter is exact.
+	std::vector<entry_index> _heap;
+	std::vector<entry_index> _heap_position;
+	size_type _max_keys;
+	count_type _total = 0;
+
+public:
+	explicit FrequencyCounter(size_type max_keys);
+
+	// Records n more occurrences of key.
+	void add(const key_type& key, count_type n = 1);
+
+	// Tracked count of key, 0 if it is not tracked. Exact while exact() holds,
+	// otherwise an overestimate by at most error(key).
+	count_type count(const key_type& key) const;
+	count_type error(const key_type& key) const;
+
+	// The k tracked entries with the highest counts, highest first.
+	std::vector<Entry> top(size_type k) const;
+
+	bool exact() const noexcept;
+	size_type size() const noexcept;
+	size_type max_keys() const noexcept;
+	count_type total() const noexcept;
+
+	void clear();
+
+private:
+	const Entry* entry_of(const key_type& key) const;
+	void build_heap();
+	void sift_down(size_type position);
+	void swap_heap(size_type a, size_type b);
+	void replace_minimum(const key_type& key, count_type n);
+};
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::FrequencyCounter(size_type max_keys)
+	: _index(static_cast<size_type>(static_cast<float>(max_keys == 0 ? 1 : max_keys) / 0.75f) + 1)
+	, _max_keys(max_keys == 0 ? 1 : max_keys)
+{
+	if (_max_keys >= std::numeric_limits<entry_index>::max())
+		throw std::length_error("FrequencyCounter max_keys is limited to 2^32 - 1");
+	_entries.reserve(_max_keys);
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::add(const key_type& key, count_type n)
+{
+	_total += n;
+
+	auto it = _index.find(key);
+	if (it != _index.end())
+	{
+		const entry_index entry = it->second;
+		_entries[entry].count += n;
+		if (!_heap.empty())
+			sift_down(_heap_position[entry]);
+		return;
+	}
+
+	if (_entries.size() < _max_keys)
+	{
+		auto [slot, inserted] = _index.insert(key, static_cast<entry_index>(_entries.size()));
+		if (slot == _index.end())
+			throw std::length_error("FrequencyCounter index has no free slot");
+		_entries.push_back({ key, n, 0 });
+		return;
+	}
+
+	if (_heap.empty())
+		build_heap();
+	replace_minimum(key, n);
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline const typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::Entry*
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::entry_of(const key_type& key) const
+{
+	auto it = _index.find(key);
+	return it == _index.end() ? nullptr : &_entries[it->second];
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::count_type
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::count(const key_type& key) const
+{
+	const Entry* entry = entry_of(key);
+	return entry ? entry->count : 0;
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::count_type
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::error(const key_type& key) const
+{
+	const Entry* entry = entry_of(key);
+	return entry ? entry->error : 0;
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::vector<typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::Entry>
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::top(size_type k) const
+{
+	std::vector<Entry> result(_entries);
+	const auto by_count = [](const Entry& a, const Entry& b) { return a.count > b.count; };
+	if (k < result.size())
+	{
+		std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(k), result.end(), by_count);
+		result.resize(k);
+	}
+	else
+		std::sort(result.begin(), result.end(), by_count);
+	return result;
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::exact() const noexcept
+{
+	return _heap.empty();
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::size_type
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::size() const noexcept
+{
+	return _entries.size();
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::size_type
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::max_keys() const noexcept
+{
+	return _max_keys;
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::count_type
+		FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::total() const noexcept
+{
+	return _total;
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	_index.clear();
+	_entries.clear();
+	_heap.clear();
+	_heap_position.clear();
+	_total = 0;
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::build_heap()
+{
+	_heap.resize(_entries.size());
+	_heap_position.resize(_entries.size());
+	for (size_type i = 0; i < _entries.size(); ++i)
+	{
+		_heap[i] = static_cast<entry_index>(i);
+		_heap_position[i] = static_cast<entry_index>(i);
+	}
+	for (size_type i = _heap.size() / 2; i-- > 0;)
+		sift_down(i);
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::sift_down(size_type position)
+{
+	// Counts only grow, so an entry can only need to move towards the leaves.
+	for (;;)
+	{
+		const size_type left = 2 * position + 1;
+		const size_type right = left + 1;
+		size_type smallest = position;
+		if (left < _heap.size() && _entries[_heap[left]].count < _entries[_heap[smallest]].count)
+			smallest = left;
+		if (right < _heap.size() && _entries[_heap[right]].count < _entries[_heap[smallest]].count)
+			smallest = right;
+		if (smallest == position)
+			return;
+		swap_heap(position, smallest);
+		position = smallest;
+	}
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::swap_heap(size_type a, size_type b)
+{
+	std::swap(_heap[a], _heap[b]);
+	_heap_position[_heap[a]] = static_cast<entry_index>(a);
+	_heap_position[_heap[b]] = static_cast<entry_index>(b);
+}
+
+template<typename Key, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void FrequencyCounter<Key, Hash, KeyEqual, ProbingStrategy>::replace_minimum(const key_type& key, count_type n)
+{
+	const entry_index victim = _heap[0];
+	Entry& entry = _entries[victim];
+
+	// Index the new key before unindexing the victim, so a throw leaves the
+	// victim tracked. The index is sized with room for one key over max_keys.
+	auto [slot, inserted] = _index.insert(key, victim);
+	if (slot == _index.end())
+	{
+		// Tombstones from earlier replacements filled the probe path; a same-size
+		// rehash clears them.
+		_index.rehash(_index.capacity());
+		std::tie(slot, inserted) = _index.insert(key, victim);
+		if (slot == _index.end())
+			throw std::length_error("FrequencyCounter index has no free slot");
+	}
+	_index.erase(entry.key);
+
+	entry.error = entry.count;
+	entry.count += n;
+	entry.key = key;
+	sift_down(0);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "StringArena.h"
+
+// 32-byte string key with its hash precomputed. Up to inline_capacity bytes are
+// stored in the key itself with a trailing length byte; longer keys keep a
+// pointer and size into a StringArena.
+class alignas(8) InlineStringKey
+{
+public:
+	static constexpr std::size_t inline_capacity = 23;
+
+private:
+	static constexpr std::uint8_t spilled_marker = 0xFF;
+
+	std::size_t _hash = 0;
+	unsigned char _bytes[inline_capacity + 1] = {};
+
+public:
+	InlineStringKey() noexcept = default;
+
+	InlineStringKey(std::string_view s, std::size_t hash, StringArena& arena)
+		: _hash(hash)
+	{
+		if (s.size() <= inline_capacity)
+		{
+			if (!s.empty())
+				std::memcpy(_bytes, s.data(), s.size());
+			_bytes[inline_capacity] = static_cast<unsigned char>(s.size());
+		}
+		else
+		{
+			const std::string_view stored = arena.store(s);
+			const char* data = stored.data();
+			const std::size_t size = stored.size();
+			std::memcpy(_bytes, &data, sizeof(data));
+			std::memcpy(_bytes + sizeof(data), &size, sizeof(size));
+			_bytes[inline_capacity] = spilled_marker;
+		}
+	}
+
+	[[nodiscard]] std::size_t hash() const noexcept { return _hash; }
+
+	[[nodiscard]] bool is_inline() const noexcept { return _bytes[inline_capacity] != spilled_marker; }
+
+	[[nodiscard]] std::string_view view() const noexcept
+	{
+		if (is_inline())
+			return std::string_view(reinterpret_cast<const char*>(_bytes), _bytes[inline_capacity]);
+
+		const char* data;
+		std::size_t size;
+		std::memcpy(&data, _bytes, sizeof(data));
+		std::memcpy(&size, _bytes + sizeof(data), sizeof(size));
+		return std::string_view(data, size);
+	}
+
+	// Rejects on the stored hash first; short keys then compare bytes in place.
+	[[nodiscard]] bool equals(std::string_view s, std::size_t hash) const noexcept
+	{
+		if (_hash != hash)
+			return false;
+		if (is_inline())
+			return _bytes[inline_capacity] == s.size() && (s.empty() || std::memcmp(_bytes, s.data(), s.size()) == 0);
+		return view() == s;
+	}
+};
+
+static_assert(sizeof(InlineStringKey) == 32, "InlineStringKey should fill half a cache line");
@@ -1,19 +1,50 @@
 #pragma once
 
 #include "ProbingStrategy.h"
+#include "FastModulo.h"
 #include <functional>
+#include <type_traits>
 
 template<typename Key>
 class LinearProbing : public IProbingStrategy<Key>
 {
+private:
+	FastModulo _modulo;
+
 public:
 	std::size_t probe(const Key& /*key*/, std::size_t hash, std::size_t attempt, std::size_t capacity) const override 
 	{
-		return (hash + attempt) % capacity;
+		return _modulo.reduce(hash + attempt, capacity);
 	} 
 
+	std::size_t next(const Key& /*key*/, std::size_t /*hash*/, std::size_t /*attempt*/, std::size_t previous, std::size_t capacity) const override
+	{
+		return previous + 1 < capacity ? previous + 1 : 0;
+	}
+
+	void set_capacity(std::size_t capacity) override
+	{
+		_modulo = FastModulo(capacity);
+	}
+
 	IProbingStrategy<Key>* clone() const override
 	{
 		return new LinearProbing<Key>(*this);
 	}
-};
\ No newline at end of file
+};
+
+// Lets tables enable techniques that are only valid for a unit-step sequence,
+// such as backward-shift deletion.
+template<typename Strategy>
+struct is_linear_probing : std::false_type {};
+
+template<typename Key>
+struct is_linear_probing<LinearProbing<Key>> : std::true_type {};
+
+// The strategy that computes positions, seen through instrumenting wrappers such as
+// CountingProbing. Calling its probe() non-virtually finds a home slot uncounted.
+template<typename Strategy>
+struct unwrapped_probing
+{
+	using type = Strategy;
+};
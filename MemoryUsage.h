@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+// Byte breakdown of one table. payload_bytes is what the stored elements need
+// on their own (including any out-of-line heap reported by a sizing hook); every
+// other field is what the table spends to hold them.
+struct MemoryUsage
+{
+	// The table object itself.
+	std::size_t object_bytes = 0;
+	// Element slots across the whole capacity, occupied or not.
+	std::size_t slot_bytes = 0;
+	// Per-slot state bytes, padding and page rounding of the slot array.
+	std::size_t metadata_bytes = 0;
+	// Directory or other index structures kept beside the slots.
+	std::size_t index_bytes = 0;
+	// Heap-allocated probing strategy.
+	std::size_t probing_bytes = 0;
+	// Out-of-line key/value heap reported by the caller's sizing hook.
+	std::size_t external_bytes = 0;
+	// Live elements plus their external heap.
+	std::size_t payload_bytes = 0;
+
+	std::size_t total() const noexcept
+	{
+		return object_bytes + slot_bytes + metadata_bytes + index_bytes + probing_bytes + external_bytes;
+	}
+
+	// Total bytes per payload byte; 1.0 would be a table with no overhead at all.
+	double overhead_ratio() const noexcept
+	{
+		return payload_bytes == 0 ? 0.0 : static_cast<double>(total()) / static_cast<double>(payload_bytes);
+	}
+
+	MemoryUsage& operator+=(const MemoryUsage& other) noexcept
+	{
+		object_bytes += other.object_bytes;
+		slot_bytes += other.slot_bytes;
+		metadata_bytes += other.metadata_bytes;
+		index_bytes += other.index_bytes;
+		probing_bytes += other.probing_bytes;
+		external_bytes += other.external_bytes;
+		payload_bytes += other.payload_bytes;
+		return *this;
+	}
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+// Minimal NUMA queries and binding via raw syscalls, so no libnuma is needed at
+// link time. Everything degrades to a single node 0 where NUMA is unavailable.
+class NumaTopology
+{
+public:
+	static constexpr int max_nodes = 1024;
+
+	static int node_count() noexcept
+	{
+		static const int count = detect_node_count();
+		return count;
+	}
+
+	static int current_node() noexcept
+	{
+#if defined(__linux__) && defined(SYS_getcpu)
+		unsigned cpu = 0;
+		unsigned node = 0;
+		if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && static_cast<int>(node) < node_count())
+			return static_cast<int>(node);
+#endif
+		return 0;
+	}
+
+	// Prefers (rather than requires) the node, so an exhausted node still falls back
+	// to remote memory instead of failing page faults.
+	static bool bind(void* data, std::size_t bytes, int node) noexcept
+	{
+#if defined(__linux__) && defined(SYS_mbind)
+		if (node < 0 || node >= max_nodes || node_count() <= 1)
+			return false;
+
+		constexpr int mpol_preferred = 1;
+		constexpr std::size_t bits_per_word = sizeof(unsigned long) * 8;
+		unsigned long mask[max_nodes / bits_per_word] = {};
+		mask[node / bits_per_word] = 1UL << (node % bits_per_word);
+		return ::syscall(SYS_mbind, data, bytes, mpol_preferred, mask, static_cast<unsigned long>(max_nodes + 1), 0) == 0;
+#else
+		(void)data;
+		(void)bytes;
+		(void)node;
+		return false;
+#endif
+	}
+
+private:
+	static int detect_node_count() noexcept
+	{
+		int count = 1;
+#if defined(__linux__)
+		// "0-3" or "0" style range list; the last number is the highest node id.
+		if (std::FILE* file = std::fopen("/sys/devices/system/node/online", "r"))
+		{
+			int first = 0;
+			int last = 0;
+			int c = 0;
+			if (std::fscanf(file, "%d", &first) == 1)
+			{
+				last = first;
+				while ((c = std::fgetc(file)) == '-' || c == ',')
+				{
+					if (std::fscanf(file, "%d", &last) != 1)
+						break;
+				}
+				count = last + 1;
+			}
+			std::fclose(file);
+		}
+#endif
+		return count < 1 ? 1 : (count > max_nodes ? max_nodes : count);
+	}
+};
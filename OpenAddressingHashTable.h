@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <chrono>
 #include <optional>
 #include <utility>
 #include <stdexcept>
@@ -8,6 +9,11 @@
 #include <unordered_set>
 
 #include "Bucket.h"
+#include "Prefetch.h"
+#include "BatchHash.h"
+#include "MemoryUsage.h"
+#include "TableListener.h"
+#include "PageAllocator.h"
 #include "ProbingStrategy.h"
 #include "LinearProbing.h"
 
@@ -33,7 +39,9 @@ public:
 	using base_probing_strategy_type = IProbingStrategy<Key>;
 
 private:
-	std::vector<bucket_type*> _buckets;
+	// Slots live directly in _storage, so a probe's first load is the slot itself.
+	bucket_type* _buckets = nullptr;
+	size_type _capacity = 0;
 	size_type _size = 0;
 	float _max_load_factor = 0.75f;
 
@@ -41,17 +49,21 @@ private:
 	key_equal _equal;
 	base_probing_strategy_type* _probing = nullptr;
 
+	PageAllocation _storage;
+	StoragePolicy _storage_policy;
+	// Not owned; copies of the table start without one.
+	ITableListener* _listener = nullptr;
+
 public:
 	template<bool IsConst>
 	class HashIterator
 	{
-		using bucket_ptr = bucket_type*;
-		using bucket_ptr_ptr = std::conditional_t<IsConst, bucket_type* const*, bucket_type**>;
+		using bucket_ptr = std::conditional_t<IsConst, const bucket_type*, bucket_type*>;
 		using value_ref = std::conditional_t<IsConst, const value_type&, value_type&>;
 		using value_ptr = std::conditional_t<IsConst, const value_type*, value_type*>;
 
-		bucket_ptr_ptr _current;
-		bucket_ptr_ptr _end;
+		bucket_ptr _current;
+		bucket_ptr _end;
 
 		void skip_to_valid();
 
@@ -63,7 +75,7 @@ public:
 		using pointer = value_ptr;
 
 		HashIterator();
-		HashIterator(bucket_ptr_ptr current, bucket_ptr_ptr end);
+		HashIterator(bucket_ptr current, bucket_ptr end);
 
 		reference operator*() const;
 		pointer operator->() const;
@@ -102,6 +114,9 @@ public:
 	template<typename M>
 	std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj);
 
+	// Under linear probing erase() backward-shifts later elements of the cluster into
+	// the freed slot, so it invalidates iterators, references and pointers to other
+	// elements. Other strategies leave a tombstone and invalidate only the erased one.
 	size_type erase(const key_type& key);
 
 	void clear();
@@ -117,6 +132,12 @@ public:
 
 	bool contains(const key_type& key) const;
 
+	// Batched lookup: results[i] points at the value for keys[i], or is null.
+	// Hashes a window of keys and prefetches their home slots before probing.
+	void find_batch(const key_type* keys, size_type count, const mapped_type** results) const;
+	// Batched insert of keys[i] -> values[i]; returns how many were inserted.
+	size_type insert_batch(const key_type* keys, const mapped_type* values, size_type count);
+
 	std::pair<iterator, iterator> equal_range(const key_type& key);
 	std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
 
@@ -133,6 +154,21 @@ public:
 	void reserve(size_type n);
 	void rehash(size_type new_capacity);
 
+	hasher hash_function() const;
+
+	const StoragePolicy& storage_policy() const noexcept;
+	void storage_policy(const StoragePolicy& policy);
+
+	ITableListener* listener() const noexcept;
+	void listener(ITableListener* listener) noexcept;
+
+	MemoryUsage memory_usage() const;
+
+	// sizer(key, mapped) returns the heap bytes an element owns outside its slot,
+	// e.g. a std::string's buffer.
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
 	iterator begin();
 	iterator end();
 	const_iterator begin() const;
@@ -149,19 +185,27 @@ public:
 	friend void swap(OpenAddressingHashTable<K, M, H, E, P, D>& lhs, OpenAddressingHashTable<K, M, H, E, P, D>& rhs) noexcept;
 
 private:
+	static constexpr size_type batch_window = 16;
+
 	size_type find_index(const key_type& key) const;
+	size_type find_index(const key_type& key, size_type hash) const;
+	void hash_window(const key_type* keys, size_type count, size_type* hashes) const;
+	void prefetch_home(const key_type& key, size_type hash) const noexcept;
 	std::pair<size_type, bool> probe_insert_slot(const key_type& key, const size_type& hash_value);
 	void check_load_and_rehash();
+	// Refills the just-emptied slot hole from the rest of its cluster (linear probing only).
+	void backward_shift(size_type hole);
 	const key_type& get_key(const value_type& val) const;
 	void allocate_buckets(size_type n);
 	void destroy_buckets();
+	void notify_insert_failure(bool during_rehash) const;
 };
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 template<bool IsConst>
 inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::HashIterator<IsConst>::skip_to_valid()
 {
-	while (_current != _end && (!(*_current) || !(*_current)->is_occupied()))
+	while (_current != _end && !_current->is_occupied())
 		++_current;
 }
 
@@ -176,7 +220,7 @@ inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDup
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 template<bool IsConst>
 inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::HashIterator<IsConst>
-		::HashIterator(bucket_ptr_ptr current, bucket_ptr_ptr end)
+		::HashIterator(bucket_ptr current, bucket_ptr end)
 	: _current(current)
 	, _end(end)
 {
@@ -188,7 +232,7 @@ template<bool IsConst>
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::HashIterator<IsConst>::reference
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::HashIterator<IsConst>::operator*() const
 {
-	return (*_current)->value_ref();
+	return _current->value_ref();
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -196,7 +240,7 @@ template<bool IsConst>
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::HashIterator<IsConst>::pointer 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::HashIterator<IsConst>::operator->() const
 {
-	return &(*_current)->value_ref();
+	return &_current->value_ref();
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -239,15 +283,21 @@ template<typename Key, typename T, typename Hash, typename KeyEqual, typename Pr
 inline typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::size_type 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::find_index(const key_type& key) const
 {
-	if (_buckets.empty())
-		return _buckets.size();
+	return find_index(key, _hash(key));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+inline typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::size_type
+		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::find_index(const key_type& key, size_type hash) const
+{
+	if (_capacity == 0)
+		return _capacity;
 
-	const size_type hash = _hash(key);
-	const size_type capacity = _buckets.size();
-	for (size_type i = 0; i < capacity; ++i)
+	const size_type capacity = _capacity;
+	size_type index = _probing->probe(key, hash, 0, capacity);
+	for (size_type i = 0; i < capacity; index = _probing->next(key, hash, ++i, index, capacity))
 	{
-		size_type index = _probing->probe(key, hash, i, capacity);
-		bucket_type* bucket = _buckets[index];
+		bucket_type* bucket = _buckets + index;
 
 		if (bucket->is_empty())
 			return capacity;
@@ -262,13 +312,15 @@ inline std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, Probin
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>
 		::probe_insert_slot(const key_type& key, const size_type& hash_value)
 {
-	size_type first_deleted_index = _buckets.size();
-	size_type capacity = _buckets.size();
+	size_type first_deleted_index = _capacity;
+	size_type capacity = _capacity;
+	if (capacity == 0)
+		return { capacity, false };
 
-	for (size_type i = 0; i < capacity; ++i)
+	size_type index = _probing->probe(key, hash_value, 0, capacity);
+	for (size_type i = 0; i < capacity; index = _probing->next(key, hash_value, ++i, index, capacity))
 	{
-		size_type index = _probing->probe(key, hash_value, i, capacity);
-		bucket_type* bucket = _buckets[index];
+		bucket_type* bucket = _buckets + index;
 
 		if (bucket->is_empty())
 			return { (first_deleted_index != capacity ? first_deleted_index : index), true };
@@ -297,7 +349,7 @@ inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, All
 {
 	if (load_factor() > max_load_factor())
 	{
-		size_type new_capacity = _buckets.size() * 2;
+		size_type new_capacity = _capacity * 2;
 		rehash(new_capacity);
 	}
 } 
@@ -312,20 +364,27 @@ inline const typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStr
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::allocate_buckets(size_type n)
 {
-	_buckets.resize(n);
-	for (auto& bucket : _buckets)
-		bucket = new bucket_type();
+	if (_probing)
+		n = _probing->adjust_capacity(n);
+
+	// Allocation is the only step that can throw; members change only after it.
+	_storage = PageAllocator::allocate(n * sizeof(bucket_type), alignof(bucket_type), _storage_policy);
+	_buckets = static_cast<bucket_type*>(_storage.data);
+	_capacity = n;
+	for (size_type i = 0; i < n; ++i)
+		new (_buckets + i) bucket_type();
+	if (_probing)
+		_probing->set_capacity(n);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::destroy_buckets()
 {
-	for (auto& bucket : _buckets)
-	{
-		delete bucket;
-		bucket = nullptr;
-	}
-	_buckets.clear();
+	for (size_type i = 0; i < _capacity; ++i)
+		_buckets[i].~bucket_type();
+	_buckets = nullptr;
+	_capacity = 0;
+	PageAllocator::deallocate(_storage);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -368,15 +427,16 @@ inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDup
 	, _size(0)
 	, _max_load_factor(other._max_load_factor)
 	, _probing(nullptr)
+	, _storage_policy(other._storage_policy)
 {
 	_probing = other._probing ? other._probing->clone() : nullptr;
-	allocate_buckets(other._buckets.size());
+	allocate_buckets(other._capacity);
 
-	for (size_type i = 0; i < other._buckets.size(); ++i)
+	for (size_type i = 0; i < other._capacity; ++i)
 	{
-		if (other._buckets[i] && other._buckets[i]->is_occupied())
+		if (other._buckets[i].is_occupied())
 		{
-			_buckets[i]->make_occupied(other._buckets[i]->key(), other._buckets[i]->get_mapped()); 
+			_buckets[i].make_occupied(other._buckets[i].key(), other._buckets[i].get_mapped()); 
 			++_size;
 		}
 	}
@@ -385,15 +445,23 @@ inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDup
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>
 		::OpenAddressingHashTable(OpenAddressingHashTable&& other) noexcept
-	: _buckets(std::move(other._buckets))
+	: _buckets(other._buckets)
+	, _capacity(other._capacity)
 	, _size(other._size)
 	, _hash(std::move(other._hash))
 	, _equal(std::move(other._equal))
 	, _max_load_factor(other._max_load_factor)
 	, _probing(other._probing)
+	, _storage(other._storage)
+	, _storage_policy(other._storage_policy)
+	, _listener(other._listener)
 {
+	other._buckets = nullptr;
+	other._capacity = 0;
 	other._size = 0;
 	other._probing = nullptr;
+	other._storage = PageAllocation();
+	other._listener = nullptr;
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -424,16 +492,17 @@ inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDup
 		_hash = other._hash;
 		_equal = other._equal;
 		_max_load_factor = other._max_load_factor;
+		_storage_policy = other._storage_policy;
 		_size = 0;
 
 		_probing = other._probing ? other._probing->clone() : nullptr;
-		allocate_buckets(other._buckets.size());
+		allocate_buckets(other._capacity);
 
-		for (size_type i = 0; i < other._buckets.size(); ++i)
+		for (size_type i = 0; i < other._capacity; ++i)
 		{
-			if (other._buckets[i] && other._buckets[i]->is_occupied())
+			if (other._buckets[i].is_occupied())
 			{
-				_buckets[i]->make_occupied(other._buckets[i]->key(), other._buckets[i]->get_mapped());
+				_buckets[i].make_occupied(other._buckets[i].key(), other._buckets[i].get_mapped());
 				++_size;
 			}
 		}
@@ -455,15 +524,23 @@ inline OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDup
 			_probing = nullptr;
 		}
 
-		_buckets = std::move(other._buckets);
+		_buckets = other._buckets;
+		_capacity = other._capacity;
 		_hash = std::move(other._hash);
 		_equal = std::move(other._equal);
 		_max_load_factor = other._max_load_factor;
 		_size = other._size;
 		_probing = other._probing;
+		_storage = other._storage;
+		_storage_policy = other._storage_policy;
+		_listener = other._listener;
 
+		other._buckets = nullptr;
+		other._capacity = 0;
 		other._probing = nullptr;
 		other._size = 0;
+		other._listener = nullptr;
+		other._storage = PageAllocation();
 	}
 	return *this;
 }
@@ -478,16 +555,19 @@ std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrate
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
 
-	if (index == _buckets.size())
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
 		return { end(), false };
+	}
 
 	if (inserted)
 	{
-		_buckets[index]->make_occupied(kv.first, kv.second);
+		_buckets[index].make_occupied(kv.first, kv.second);
 		++_size;
 	}
 
-	return { iterator(_buckets.data() + index, _buckets.data() + _buckets.size()), inserted };
+	return { iterator(_buckets + index, _buckets + _capacity), inserted };
 }  
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -500,16 +580,19 @@ std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrate
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
 
-	if (index == _buckets.size())
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
 		return { end(), false };
+	}
 
 	if (inserted)
 	{
-		_buckets[index]->make_occupied(std::move(kv.first), std::move(kv.second));
+		_buckets[index].make_occupied(std::move(kv.first), std::move(kv.second));
 		++_size;
 	}
 
-	return { iterator(_buckets.data() + index, _buckets.data() + _buckets.size()), inserted };
+	return { iterator(_buckets + index, _buckets + _capacity), inserted };
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -521,15 +604,18 @@ std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrate
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
 
-	if (index == _buckets.size())
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
 		return { end(), false };
+	}
 
 	if (inserted)
 	{
-		_buckets[index]->make_occupied(key, value);
+		_buckets[index].make_occupied(key, value);
 		++_size;
 	}
-	return { iterator(_buckets.data() + index, _buckets.data() + _buckets.size()), inserted };
+	return { iterator(_buckets + index, _buckets + _capacity), inserted };
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -545,16 +631,19 @@ inline std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, Probin
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
 
-	if (index == _buckets.size())
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
 		return { end(), false };
+	}
 
 	if (inserted)
 	{
-		_buckets[index]->make_occupied(std::move(val));
+		_buckets[index].make_occupied(std::move(val));
 		++_size;
 	}
 
-	return{ iterator(_buckets.data() + index, _buckets.data() + _buckets.size()), inserted };
+	return{ iterator(_buckets + index, _buckets + _capacity), inserted };
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -568,19 +657,22 @@ inline std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, Probin
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
 
-	if (index == _buckets.size())
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
 		return { end(), false };
+	}
 
 	if (inserted)
 	{
 		if constexpr (std::is_same_v<Key, T>)
-			_buckets[index]->make_occupied(key);
+			_buckets[index].make_occupied(key);
 		else
-			_buckets[index]->make_occupied(key, std::forward<Args>(args)...);
+			_buckets[index].make_occupied(key, std::forward<Args>(args)...);
 		++_size;
 	}
 
-	return { iterator(_buckets.data() + index, _buckets.data() + _buckets.size()), inserted };
+	return { iterator(_buckets + index, _buckets + _capacity), inserted };
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -594,18 +686,21 @@ inline std::pair<typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, Probin
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
 
-	if (index == _buckets.size())
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
 		return { end(), false };
+	}
 
 	if (inserted)
 	{
-		_buckets[index]->make_occupied(key, std::forward<M>(obj));
+		_buckets[index].make_occupied(key, std::forward<M>(obj));
 		++_size;
 	}
 	else
-		_buckets[index]->get_mapped() = std::forward<M>(obj);
+		_buckets[index].get_mapped() = std::forward<M>(obj);
 	
-	return { iterator(_buckets.data() + index, _buckets.data() + _buckets.size()), inserted };
+	return { iterator(_buckets + index, _buckets + _capacity), inserted };
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -613,22 +708,67 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::erase(const key_type& key)
 {
 	size_type index = find_index(key);
-	if (index == _buckets.size() || !_buckets[index] || !_buckets[index]->is_occupied())
+	if (index == _capacity || !_buckets[index].is_occupied())
 		return 0;
 
-	_buckets[index]->make_deleted();
+	if constexpr (is_linear_probing<ProbingStrategy>::value)
+	{
+		_buckets[index].make_empty();
+		backward_shift(index);
+	}
+	else
+		_buckets[index].make_deleted();
 	--_size;
 	return 1;
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
-void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::clear()
+void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::backward_shift(size_type hole)
 {
-	for (auto* bucket : _buckets)
+	// Knuth's Algorithm R: walk the rest of the cluster and pull back every element
+	// whose home slot is not cyclically in (hole, index], so no probe sequence
+	// crosses the freed slot and no tombstone is left behind.
+	using home_strategy = typename unwrapped_probing<ProbingStrategy>::type;
+	const size_type capacity = _capacity;
+	size_type index = hole;
+	for (size_type i = 1; i < capacity; ++i)
 	{
-		if (bucket)
-			bucket->clear();
+		index = index + 1 < capacity ? index + 1 : 0;
+		bucket_type* bucket = _buckets + index;
+		if (bucket->is_empty())
+			return;
+		if (bucket->is_deleted())
+		{
+			// Only a failed shift leaves tombstones; keep the chain intact past it.
+			_buckets[hole].make_deleted();
+			return;
+		}
+
+		const key_type& key = bucket->key();
+		const size_type home = static_cast<const ProbingStrategy*>(_probing)->home_strategy::probe(key, _hash(key), 0, capacity);
+		const bool stays = hole <= index ? (hole < home && home <= index) : (hole < home || home <= index);
+		if (stays)
+			continue;
+
+		try
+		{
+			_buckets[hole].make_occupied(std::move(bucket->value()));
+		}
+		catch (...)
+		{
+			_buckets[hole].make_deleted();
+			return;
+		}
+		bucket->make_empty();
+		hole = index;
 	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::clear()
+{
+	for (size_type i = 0; i < _capacity; ++i)
+		_buckets[i].clear();
 	_size = 0;
 }
 
@@ -640,7 +780,17 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
-	bucket_type* bucket = _buckets[index];
+
+	// No free slot on the probe path (tombstones can exhaust it for sequences
+	// that do not visit every slot): grow, which also drops tombstones, and retry.
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
+		rehash(_capacity == 0 ? 16 : _capacity * 2);
+		return (*this)[key];
+	}
+
+	bucket_type* bucket = _buckets + index;
 
 	if (inserted)
 	{
@@ -658,7 +808,17 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 
 	size_type hash_value = _hash(key);
 	auto [index, inserted] = probe_insert_slot(key, hash_value);
-	bucket_type* bucket = _buckets[index];
+
+	// No free slot on the probe path (tombstones can exhaust it for sequences
+	// that do not visit every slot): grow, which also drops tombstones, and retry.
+	if (index == _capacity)
+	{
+		notify_insert_failure(false);
+		rehash(_capacity == 0 ? 16 : _capacity * 2);
+		return (*this)[std::move(key)];
+	}
+
+	bucket_type* bucket = _buckets + index;
 
 	if (inserted)
 	{
@@ -673,9 +833,9 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::at(const key_type& key)
 {
 	size_type index = find_index(key);
-	if (index == _buckets.size() || !_buckets[index]->is_occupied())
+	if (index == _capacity || !_buckets[index].is_occupied())
 		throw std::out_of_range("Key not found");
-	return _buckets[index]->get_mapped();
+	return _buckets[index].get_mapped();
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -683,9 +843,9 @@ const typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy,
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::at(const key_type& key) const
 {
 	size_type index = find_index(key);
-	if (index == _buckets.size() || !_buckets[index]->is_occupied())
+	if (index == _capacity || !_buckets[index].is_occupied())
 		throw std::out_of_range("Key not found");
-	return _buckets[index]->get_mapped();
+	return _buckets[index].get_mapped();
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -693,9 +853,9 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::find(const key_type& key)
 {
 	size_type index = find_index(key);
-	if (index == _buckets.size() || !_buckets[index] || !_buckets[index]->is_occupied())
+	if (index == _capacity || !_buckets[index].is_occupied())
 		return end();
-	return iterator(_buckets.data() + index, _buckets.data() + _buckets.size());
+	return iterator(_buckets + index, _buckets + _capacity);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -703,16 +863,91 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::find(const key_type& key) const
 {
 	size_type index = find_index(key);
-	if (index == _buckets.size() || !_buckets[index]->is_occupied())
+	if (index == _capacity || !_buckets[index].is_occupied())
 		return cend();
-	return const_iterator(_buckets.data() + index, _buckets.data() + _buckets.size());
+	return const_iterator(_buckets + index, _buckets + _capacity);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 bool OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::contains(const key_type& key) const
 {
 	size_type index = find_index(key);
-	return index != _buckets.size() && _buckets[index]->is_occupied();
+	return index != _capacity && _buckets[index].is_occupied();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>
+		::hash_window(const key_type* keys, size_type count, size_type* hashes) const
+{
+	hash_keys(_hash, keys, count, hashes);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>
+		::prefetch_home(const key_type& key, size_type hash) const noexcept
+{
+	if (_capacity == 0)
+		return;
+	const size_type index = _probing->probe(key, hash, 0, _capacity);
+	prefetch_read(_buckets + index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>
+		::find_batch(const key_type* keys, size_type count, const mapped_type** results) const
+{
+	size_type hashes[batch_window];
+	for (size_type base = 0; base < count; base += batch_window)
+	{
+		const size_type n = count - base < batch_window ? count - base : batch_window;
+		hash_window(keys + base, n, hashes);
+		for (size_type i = 0; i < n; ++i)
+			prefetch_home(keys[base + i], hashes[i]);
+
+		for (size_type i = 0; i < n; ++i)
+		{
+			const size_type index = find_index(keys[base + i], hashes[i]);
+			results[base + i] = index == _capacity ? nullptr : &_buckets[index].get_mapped();
+		}
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::size_type
+		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>
+		::insert_batch(const key_type* keys, const mapped_type* values, size_type count)
+{
+	// Grow once up front so no rehash invalidates a window's hashes mid-batch.
+	const size_type needed = static_cast<size_type>(static_cast<float>(_size + count) / _max_load_factor) + 1;
+	if (needed > _capacity)
+		rehash(needed);
+
+	size_type inserted_count = 0;
+	size_type hashes[batch_window];
+	for (size_type base = 0; base < count; base += batch_window)
+	{
+		const size_type n = count - base < batch_window ? count - base : batch_window;
+		hash_window(keys + base, n, hashes);
+		for (size_type i = 0; i < n; ++i)
+			prefetch_home(keys[base + i], hashes[i]);
+
+		for (size_type i = 0; i < n; ++i)
+		{
+			auto [index, inserted] = probe_insert_slot(keys[base + i], hashes[i]);
+			if (index == _capacity)
+			{
+				notify_insert_failure(false);
+				continue;
+			}
+			if (inserted)
+			{
+				_buckets[index].make_occupied(keys[base + i], values[base + i]);
+				++_size;
+				++inserted_count;
+			}
+		}
+	}
+	return inserted_count;
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -772,9 +1007,9 @@ typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowD
 	else
 	{
 		size_type result = 0;
-		for (const auto& bucket : _buckets)
+		for (size_type i = 0; i < _capacity; ++i)
 		{
-			if (bucket && bucket->is_occupied() && _equal(bucket->key(), key))
+			if (_buckets[i].is_occupied() && _equal(_buckets[i].key(), key))
 				++result;
 		}
 		return result;
@@ -798,13 +1033,13 @@ template<typename Key, typename T, typename Hash, typename KeyEqual, typename Pr
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::size_type 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::capacity() const noexcept
 {
-	return _buckets.size();
+	return _capacity;
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 float OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::load_factor() const noexcept
 {
-	return _buckets.empty() ? 0.0f : static_cast<float>(_size) / static_cast<float>(_buckets.size());
+	return _capacity == 0 ? 0.0f : static_cast<float>(_size) / static_cast<float>(_capacity);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -825,52 +1060,158 @@ void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDupli
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::reserve(size_type n)
 {
-	if (n > _buckets.size())
+	if (n > _capacity)
 		rehash(n);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::rehash(size_type new_capacity)
 {
-	std::vector<bucket_type*> old_buckets = std::move(_buckets);
-	size_type old_size = _size;
+	RehashEvent event;
+	std::chrono::steady_clock::time_point start;
+	if (_listener)
+	{
+		event.old_capacity = _capacity;
+		event.new_capacity = _probing ? _probing->adjust_capacity(new_capacity) : new_capacity;
+		event.size = _size;
+		_listener->on_rehash_begin(event);
+		start = std::chrono::steady_clock::now();
+	}
 
-	destroy_buckets();
-	allocate_buckets(new_capacity);
+	bucket_type* old_buckets = _buckets;
+	const size_type old_capacity = _capacity;
+	const size_type old_size = _size;
+	PageAllocation old_storage = _storage;
 
+	// A throw here leaves the table untouched.
+	allocate_buckets(new_capacity);
 	_size = 0;
 
-	for (auto bucket : old_buckets)
+	try
 	{
-		if (bucket && bucket->is_occupied())
+		for (size_type i = 0; i < old_capacity; ++i)
 		{
-			const auto& val = bucket->value();
-			const key_type& key = get_key(val);
-			size_type hash_value = _hash(key);
-
-			auto [index, inserted] = probe_insert_slot(key, hash_value);
-			if (inserted)
+			const bucket_type& bucket = old_buckets[i];
+			if (bucket.is_occupied())
 			{
-				_buckets[index]->set(val);
-				++_size;
+				const auto& val = bucket.value();
+				const key_type& key = get_key(val);
+				size_type hash_value = _hash(key);
+
+				auto [index, inserted] = probe_insert_slot(key, hash_value);
+				if (inserted)
+				{
+					_buckets[index].set(val);
+					++_size;
+				}
+				else if (index == _capacity)
+					notify_insert_failure(true);
 			}
+			else if (bucket.is_deleted())
+				++event.tombstones_purged;
 		}
-		delete bucket; //   
 	}
+	catch (...)
+	{
+		// Old slots were only copied from, so put them back as they were.
+		destroy_buckets();
+		_buckets = old_buckets;
+		_capacity = old_capacity;
+		_size = old_size;
+		_storage = old_storage;
+		if (_probing)
+			_probing->set_capacity(old_capacity);
+		throw;
+	}
+
+	for (size_type i = 0; i < old_capacity; ++i)
+		old_buckets[i].~bucket_type();
+	PageAllocator::deallocate(old_storage);
+
+	if (_listener)
+	{
+		event.size = _size;
+		event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		_listener->on_rehash_end(event);
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::hasher
+		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::hash_function() const
+{
+	return _hash;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+const StoragePolicy& OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::storage_policy() const noexcept
+{
+	return _storage_policy;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::storage_policy(const StoragePolicy& policy)
+{
+	_storage_policy = policy;
+	rehash(_capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+ITableListener* OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::listener() const noexcept
+{
+	return _listener;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::listener(ITableListener* listener) noexcept
+{
+	_listener = listener;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::notify_insert_failure(bool during_rehash) const
+{
+	if (_listener)
+		_listener->on_insert_failure(InsertFailureEvent{ _capacity, _size, during_rehash });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+MemoryUsage OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
+template<typename Sizer>
+MemoryUsage OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage;
+	usage.object_bytes = sizeof(*this);
+	usage.slot_bytes = _capacity * sizeof(value_type);
+	usage.metadata_bytes = _storage.bytes > usage.slot_bytes ? _storage.bytes - usage.slot_bytes : 0;
+	usage.probing_bytes = _probing ? sizeof(ProbingStrategy) : 0;
+
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_buckets[i].is_occupied())
+			usage.external_bytes += sizer(_buckets[i].key(), _buckets[i].get_mapped());
+	}
+	usage.payload_bytes = _size * sizeof(value_type) + usage.external_bytes;
+	return usage;
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::iterator 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::begin()
 {
-	return iterator(_buckets.data(), _buckets.data() + _buckets.size());
+	return iterator(_buckets, _buckets + _capacity);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::iterator 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::end()
 {
-	auto end_ptr = _buckets.data() + _buckets.size();
+	auto end_ptr = _buckets + _capacity;
 	return iterator(end_ptr, end_ptr);
 }
 
@@ -878,14 +1219,14 @@ template<typename Key, typename T, typename Hash, typename KeyEqual, typename Pr
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::const_iterator 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::begin() const
 {
-	return const_iterator(_buckets.data(), _buckets.data() + _buckets.size());
+	return const_iterator(_buckets, _buckets + _capacity);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::const_iterator 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::end() const
 {
-	auto end_ptr = _buckets.data() + _buckets.size();
+	auto end_ptr = _buckets + _capacity;
 	return const_iterator(end_ptr, end_ptr);
 }
 
@@ -893,14 +1234,14 @@ template<typename Key, typename T, typename Hash, typename KeyEqual, typename Pr
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::const_iterator 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::cbegin() const
 {
-	return const_iterator(_buckets.data(), _buckets.data() + _buckets.size());
+	return const_iterator(_buckets, _buckets + _capacity);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
 typename OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::const_iterator 
 		OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, AllowDuplicates>::cend() const
 {
-	auto end_ptr = _buckets.data() + _buckets.size();
+	auto end_ptr = _buckets + _capacity;
 	return const_iterator(end_ptr, end_ptr);
 }
 
@@ -909,11 +1250,15 @@ inline void OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy, All
 		::swap(OpenAddressingHashTable& other) noexcept
 {
 	std::swap(_buckets, other._buckets);
+	std::swap(_capacity, other._capacity);
 	std::swap(_size, other._size);
 	std::swap(_max_load_factor, other._max_load_factor);
 	std::swap(_hash, other._hash);
 	std::swap(_equal, other._equal);
 	std::swap(_probing, other._probing);
+	std::swap(_storage, other._storage);
+	std::swap(_storage_policy, other._storage_policy);
+	std::swap(_listener, other._listener);
 }
 
 template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy, bool AllowDuplicates>
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+
+enum class TraceOperation : std::uint8_t
+{
+	INSERT,
+	FIND,
+	ERASE,
+	SUBSCRIPT
+};
+
+struct TraceRecord
+{
+	TraceOperation operation;
+	std::uint64_t key_hash;
+};
+
+// Binary trace layout: an 8-byte header ("OAHTRC" plus a 16-bit version) followed
+// by 9-byte records, one operation byte and a little-endian 64-bit key hash.
+// Only hashes are kept, which preserves the access pattern and key identity
+// without copying user keys into the file.
+namespace trace_format
+{
+	inline constexpr char magic[6] = { 'O', 'A', 'H', 'T', 'R', 'C' };
+	inline constexpr std::uint16_t version = 1;
+	inline constexpr std::size_t record_size = 9;
+}
+
+class TraceWriter
+{
+private:
+	std::ofstream _out;
+	std::size_t _count = 0;
+
+public:
+	explicit TraceWriter(const std::string& path)
+		: _out(path, std::ios::binary | std::ios::trunc)
+	{
+		if (!_out)
+			throw std::runtime_error("Cannot open trace file for writing: " + path);
+
+		unsigned char header[8];
+		std::memcpy(header, trace_format::magic, sizeof(trace_format::magic));
+		header[6] = static_cast<unsigned char>(trace_format::version & 0xFF);
+		header[7] = static_cast<unsigned char>(trace_format::version >> 8);
+		_out.write(reinterpret_cast<const char*>(header), sizeof(header));
+		check_stream();
+	}
+
+	void record(TraceOperation operation, std::uint64_t key_hash)
+	{
+		unsigned char bytes[trace_format::record_size];
+		bytes[0] = static_cast<unsigned char>(operation);
+		for (std::size_t i = 0; i < 8; ++i)
+			bytes[1 + i] = static_cast<unsigned char>(key_hash >> (8 * i));
+		_out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+		check_stream();
+		++_count;
+	}
+
+	void flush()
+	{
+		_out.flush();
+		check_stream();
+	}
+
+	std::size_t count() const noexcept { return _count; }
+
+private:
+	// A full disk would otherwise leave a silently truncated trace.
+	void check_stream()
+	{
+		if (!_out)
+			throw std::runtime_error("Failed to write trace file");
+	}
+};
+
+inline std::vector<TraceRecord> read_trace(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		throw std::runtime_error("Cannot open trace file: " + path);
+
+	unsigned char header[8];
+	if (!in.read(reinterpret_cast<char*>(header), sizeof(header))
+		|| std::memcmp(header, trace_format::magic, sizeof(trace_format::magic)) != 0)
+		throw std::runtime_error("Not a trace file: " + path);
+
+	const std::uint16_t version = static_cast<std::uint16_t>(header[6] | (header[7] << 8));
+	if (version != trace_format::version)
+		throw std::runtime_error("Unsupported trace version in " + path);
+
+	std::vector<TraceRecord> records;
+	unsigned char bytes[trace_format::record_size];
+	while (in.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+	{
+		if (bytes[0] > static_cast<unsigned char>(TraceOperation::SUBSCRIPT))
+			throw std::runtime_error("Corrupt trace record in " + path);
+
+		std::uint64_t key_hash = 0;
+		for (std::size_t i = 0; i < 8; ++i)
+			key_hash |= static_cast<std::uint64_t>(bytes[1 + i]) << (8 * i);
+		records.push_back({ static_cast<TraceOperation>(bytes[0]), key_hash });
+	}
+	return records;
+}
+
+// Forwards the traced operations to Table and logs each one with its key hash.
+// Recording is opt-in by wrapping; the tables themselves carry no tracing hooks.
+template<typename Table>
+class TracedHashTable
+{
+public:
+	using table_type = Table;
+	using key_type = typename Table::key_type;
+	using mapped_type = typename Table::mapped_type;
+	using hasher = typename Table::hasher;
+	using size_type = typename Table::size_type;
+	using iterator = typename Table::iterator;
+	using const_iterator = typename Table::const_iterator;
+
+private:
+	Table _table;
+	TraceWriter* _writer;
+	// Copied from the table so a stateful hasher records the hashes it probes with.
+	hasher _hash;
+
+public:
+	template<typename... Args>
+	explicit TracedHashTable(TraceWriter& writer, Args&&... args)
+		: _table(std::forward<Args>(args)...)
+		, _writer(&writer)
+		, _hash(_table.hash_function())
+	{
+	}
+
+	std::pair<iterator, bool> insert(const key_type& key, const mapped_type& value)
+	{
+		record(TraceOperation::INSERT, key);
+		return _table.insert(key, value);
+	}
+
+	iterator find(const key_type& key)
+	{
+		record(TraceOperation::FIND, key);
+		return _table.find(key);
+	}
+
+	size_type erase(const key_type& key)
+	{
+		record(TraceOperation::ERASE, key);
+		return _table.erase(key);
+	}
+
+	mapped_type& operator[](const key_type& key)
+	{
+		record(TraceOperation::SUBSCRIPT, key);
+		return _table[key];
+	}
+
+	iterator end() { return _table.end(); }
+	size_type size() const noexcept { return _table.size(); }
+
+	Table& table() noexcept { return _table; }
+	const Table& table() const noexcept { return _table; }
+
+private:
+	void record(TraceOperation operation, const key_type& key)
+	{
+		_writer->record(operation, static_cast<std::uint64_t>(_hash(key)));
+	}
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#include "NumaTopology.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+struct StoragePolicy
+{
+	// Arrays of at least this many bytes are mapped with transparent huge pages.
+	std::size_t huge_page_threshold = std::size_t(32) << 20;
+	// Try explicit hugetlbfs pages (MAP_HUGETLB) first; needs a reserved pool.
+	bool use_hugetlbfs = false;
+	// Preferred NUMA node for the array, or -1 to leave placement to first touch.
+	int numa_node = -1;
+};
+
+enum class PageAllocationKind
+{
+	NONE,
+	HEAP,
+	MAPPED,
+	HUGETLB
+};
+
+struct PageAllocation
+{
+	void* data = nullptr;
+	std::size_t bytes = 0;
+	std::size_t alignment = alignof(std::max_align_t);
+	PageAllocationKind kind = PageAllocationKind::NONE;
+};
+
+class PageAllocator
+{
+public:
+	static constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+	static PageAllocation allocate(std::size_t bytes, std::size_t alignment, const StoragePolicy& policy)
+	{
+		PageAllocation allocation;
+		allocation.alignment = alignment;
+		if (bytes == 0)
+			return allocation;
+
+#if defined(__linux__)
+		const bool bind = policy.numa_node >= 0 && NumaTopology::node_count() > 1;
+		if (bind && bytes < policy.huge_page_threshold && alignment <= page_size())
+		{
+			// Binding needs a page-aligned range of its own, so map even small arrays.
+			const std::size_t rounded = round_up(bytes, page_size());
+			void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p != MAP_FAILED)
+			{
+				NumaTopology::bind(p, rounded, policy.numa_node);
+				allocation.data = p;
+				allocation.bytes = rounded;
+				allocation.kind = PageAllocationKind::MAPPED;
+				return allocation;
+			}
+		}
+
+		if (bytes >= policy.huge_page_threshold && alignment <= huge_page_size)
+		{
+			const std::size_t rounded = round_up(bytes, huge_page_size);
+
+#if defined(MAP_HUGETLB)
+			if (policy.use_hugetlbfs)
+			{
+				void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+				if (p != MAP_FAILED)
+				{
+					if (bind)
+						NumaTopology::bind(p, rounded, policy.numa_node);
+					allocation.data = p;
+					allocation.bytes = rounded;
+					allocation.kind = PageAllocationKind::HUGETLB;
+					return allocation;
+				}
+			}
+#endif
+
+			// Over-map by one huge page and trim so the range is 2 MB aligned, which
+			// is what lets khugepaged back it with huge pages.
+			void* p = ::mmap(nullptr, rounded + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p != MAP_FAILED)
+			{
+				const std::uintptr_t raw = reinterpret_cast<std::uintptr_t>(p);
+				const std::uintptr_t aligned = round_up(raw, huge_page_size);
+				if (aligned != raw)
+					::munmap(p, aligned - raw);
+				const std::uintptr_t tail = aligned + rounded;
+				const std::uintptr_t raw_end = raw + rounded + huge_page_size;
+				if (raw_end != tail)
+					::munmap(reinterpret_cast<void*>(tail), raw_end - tail);
+
+#if defined(MADV_HUGEPAGE)
+				::madvise(reinterpret_cast<void*>(aligned), rounded, MADV_HUGEPAGE);
+#endif
+				if (bind)
+					NumaTopology::bind(reinterpret_cast<void*>(aligned), rounded, policy.numa_node);
+				allocation.data = reinterpret_cast<void*>(aligned);
+				allocation.bytes = rounded;
+				allocation.kind = PageAllocationKind::MAPPED;
+				return allocation;
+			}
+		}
+#else
+		(void)policy;
+#endif
+
+		allocation.data = ::operator new(bytes, std::align_val_t(alignment));
+		allocation.bytes = bytes;
+		allocation.kind = PageAllocationKind::HEAP;
+		return allocation;
+	}
+
+	static void deallocate(PageAllocation& allocation) noexcept
+	{
+		switch (allocation.kind)
+		{
+		case PageAllocationKind::HEAP:
+			::operator delete(allocation.data, std::align_val_t(allocation.alignment));
+			break;
+#if defined(__linux__)
+		case PageAllocationKind::MAPPED:
+		case PageAllocationKind::HUGETLB:
+			::munmap(allocation.data, allocation.bytes);
+			break;
+#endif
+		default:
+			break;
+		}
+		allocation = PageAllocation();
+	}
+
+private:
+#if defined(__linux__)
+	static std::size_t page_size() noexcept
+	{
+		static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		return size;
+	}
+#endif
+
+	static std::size_t round_up(std::size_t value, std::size_t multiple) noexcept
+	{
+		return (value + multiple - 1) / multiple * multiple;
+	}
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+
+#include "BatchHash.h"
+#include "OpenAddressingHashTable.h"
+
+// Radix-partitioned hash join and grouped aggregation over columns of keys.
+// Both inputs are split by the top bits of a mixed hash into partitions whose
+// build-side OpenAddressingHashTable fits in partition_bytes (sized for L2), so
+// each partition's build and probe stay in cache. Probes go through find_batch(),
+// which overlaps the home-slot misses of a window of keys.
+//
+// Inputs are pointer/count pairs (the tree is C++17, no std::span). Rows are
+// reported by their index in the input, as 32-bit row numbers.
+template<
+	typename Key,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>
+>
+class PartitionedHashJoin
+{
+public:
+	using key_type = Key;
+	using size_type = std::size_t;
+	using row_type = std::uint32_t;
+
+	struct Match
+	{
+		row_type build_row;
+		row_type probe_row;
+	};
+
+private:
+	using table_type = OpenAddressingHashTable<Key, row_type, Hash, KeyEqual>;
+
+	static constexpr row_type no_row = std::numeric_limits<row_type>::max();
+	static constexpr unsigned max_radix_bits = 12;
+	static constexpr size_type hash_chunk = 256;
+
+	// Rows grouped by partition: partition p is [offsets[p], offsets[p + 1]) of both
+	// rows and keys. Keys are scattered alongside their row numbers so a partition's
+	// build and probe read one contiguous, cache-resident run instead of the input.
+	struct Partitions
+	{
+		std::vector<row_type> rows;
+		std::vector<key_type> keys;
+		std::vector<size_type> offsets;
+	};
+
+	// Build side of one partition: table maps a key to its last build row and
+	// next[] chains earlier rows with the same key.
+	struct BuildPartition
+	{
+		table_type table;
+		std::vector<row_type> next;
+
+		BuildPartition(size_type capacity, const Hash& hash)
+			: table(make_table(capacity, hash))
+		{
+		}
+	};
+
+	size_type _partition_bytes;
+	Hash _hash;
+
+public:
+	explicit PartitionedHashJoin(size_type partition_bytes = 256 * 1024, const Hash& hash = Hash());
+
+	std::vector<Match> inner_join(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count) const;
+
+	// Probe rows with at least one match, in input order within each partition.
+	std::vector<row_type> semi_join(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count) const;
+
+	// Probe rows with no match.
+	std::vector<row_type> anti_join(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count) const;
+
+	// Groups rows by key and folds values[i] into its group's accumulator with
+	// combine(Acc&, const Value&), starting from init. One entry per distinct key.
+	template<typename Value, typename Acc, typename Combine>
+	std::vector<std::pair<key_type, Acc>> group_by(const key_type* keys, const Value* values, size_type count, const Acc& init, Combine combine) const;
+
+	size_type partition_bytes() const noexcept;
+
+private:
+	unsigned radix_bits_for(size_type rows) const noexcept;
+	static size_type partition_of(size_type hash, unsigned bits) noexcept;
+	// Partition tables hash with the join's own hasher, so a seeded one applies
+	// to them as well as to partitioning.
+	static table_type make_table(size_type capacity, const Hash& hash);
+	Partitions partition(const key_type* keys, size_type count, unsigned bits) const;
+	BuildPartition build_partition(const Partitions& partitions, size_type p) const;
+
+	// Calls visit(probe_row, head, next, build_partitions, build_begin) for every
+	// probe row, where head is the partition-local index of the last matching
+	// build row (or no_row) and next chains the earlier ones.
+	template<typename Visit>
+	void probe_partitions(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count, Visit visit) const;
+
+	static void check_rows(size_type count);
+};
+
+template<typename Key, typename Hash, typename KeyEqual>
+inline PartitionedHashJoin<Key, Hash, KeyEqual>::PartitionedHashJoin(size_type partition_bytes, const Hash& hash)
+	: _partition_bytes(partition_bytes == 0 ? 1 : partition_bytes)
+	, _hash(hash)
+{
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+inline void PartitionedHashJoin<Key, Hash, KeyEqual>::check_rows(size_type count)
+{
+	if (count >= no_row)
+		throw std::length_error("PartitionedHashJoin inputs are limited to 2^32 - 1 rows");
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+inline unsigned PartitionedHashJoin<Key, Hash, KeyEqual>::radix_bits_for(size_type rows) const noexcept
+{
+	// A build row costs its bucket, inflated by the load factor.
+	const size_type bytes_per_row = sizeof(typename table_type::bucket_type) * 4 / 3;
+	const size_type total = rows * bytes_per_row;
+
+	unsigned bits = 0;
+	while (bits < max_radix_bits && (total >> bits) > _partition_bytes)
+		++bits;
+	return bits;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+inline typename PartitionedHashJoin<Key, Hash, KeyEqual>::size_type
+		PartitionedHashJoin<Key, Hash, KeyEqual>::partition_of(size_type hash, unsigned bits) noexcept
+{
+	if (bits == 0)
+		return 0;
+	// The partition tables reduce the low bits of the same hash, so partition on
+	// the top bits of a mixed value to keep the two independent.
+	const std::uint64_t mixed = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+	return static_cast<size_type>(mixed >> (64 - bits));
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+inline typename PartitionedHashJoin<Key, Hash, KeyEqual>::table_type
+		PartitionedHashJoin<Key, Hash, KeyEqual>::make_table(size_type capacity, const Hash& hash)
+{
+	return table_type(capacity, hash, KeyEqual(), typename table_type::probing_strategy_type());
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+typename PartitionedHashJoin<Key, Hash, KeyEqual>::Partitions
+		PartitionedHashJoin<Key, Hash, KeyEqual>::partition(const key_type* keys, size_type count, unsigned bits) const
+{
+	const size_type partition_count = size_type(1) << bits;
+
+	std::vector<size_type> targets(count);
+	Partitions partitions;
+	partitions.offsets.assign(partition_count + 1, 0);
+	if (bits != 0)
+	{
+		// Hash into targets in chunks so hashers with a batch kernel can use it.
+		size_type hashes[hash_chunk];
+		for (size_type base = 0; base < count; base += hash_chunk)
+		{
+			const size_type n = count - base < hash_chunk ? count - base : hash_chunk;
+			hash_keys(_hash, keys + base, n, hashes);
+			for (size_type i = 0; i < n; ++i)
+				targets[base + i] = partition_of(hashes[i], bits);
+		}
+	}
+	for (size_type i = 0; i < count; ++i)
+		++partitions.offsets[targets[i] + 1];
+	for (size_type p = 0; p < partition_count; ++p)
+		partitions.offsets[p + 1] += partitions.offsets[p];
+
+	std::vector<size_type> cursor(partitions.offsets.begin(), partitions.offsets.end() - 1);
+	partitions.rows.resize(count);
+	// Seeded from the input so Key need not be default-constructible.
+	partitions.keys.assign(keys, keys + count);
+	for (size_type i = 0; i < count; ++i)
+	{
+		const size_type slot = cursor[targets[i]]++;
+		partitions.rows[slot] = static_cast<row_type>(i);
+		partitions.keys[slot] = keys[i];
+	}
+	return partitions;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+typename PartitionedHashJoin<Key, Hash, KeyEqual>::BuildPartition
+		PartitionedHashJoin<Key, Hash, KeyEqual>::build_partition(const Partitions& partitions, size_type p) const
+{
+	const size_type begin = partitions.offsets[p];
+	const size_type end = partitions.offsets[p + 1];
+
+	BuildPartition result((end - begin) * 4 / 3 + 1, _hash);
+	result.next.assign(end - begin, no_row);
+	for (size_type i = begin; i < end; ++i)
+	{
+		auto [it, inserted] = result.table.insert(partitions.keys[i], static_cast<row_type>(i - begin));
+		// Dropping the row would silently lose its matches.
+		if (it == result.table.end())
+			throw std::length_error("PartitionedHashJoin build table has no free slot");
+		if (!inserted)
+		{
+			result.next[i - begin] = it->second;
+			it->second = static_cast<row_type>(i - begin);
+		}
+	}
+	return result;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+template<typename Visit>
+void PartitionedHashJoin<Key, Hash, KeyEqual>::probe_partitions(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count, Visit visit) const
+{
+	check_rows(build_count);
+	check_rows(probe_count);
+
+	const unsigned bits = radix_bits_for(build_count);
+	const Partitions build_partitions = partition(build, build_count, bits);
+	const Partitions probe_side = partition(probe, probe_count, bits);
+
+	const std::vector<row_type> no_next;
+	std::vector<const row_type*> window_results;
+	for (size_type p = 0; p + 1 < build_partitions.offsets.size(); ++p)
+	{
+		const size_type probe_begin = probe_side.offsets[p];
+		const size_type probe_end = probe_side.offsets[p + 1];
+		if (probe_begin == probe_end)
+			continue;
+
+		const size_type build_begin = build_partitions.offsets[p];
+		if (build_begin == build_partitions.offsets[p + 1])
+		{
+			for (size_type i = probe_begin; i < probe_end; ++i)
+				visit(probe_side.rows[i], no_row, no_next, build_partitions, build_begin);
+			continue;
+		}
+
+		const BuildPartition built = build_partition(build_partitions, p);
+
+		// The partition's probe keys are already contiguous for find_batch.
+		const size_type probe_rows = probe_end - probe_begin;
+		window_results.resize(probe_rows);
+		built.table.find_batch(probe_side.keys.data() + probe_begin, probe_rows, window_results.data());
+
+		for (size_type i = 0; i < probe_rows; ++i)
+		{
+			const row_type probe_row = probe_side.rows[probe_begin + i];
+			if (window_results[i] == nullptr)
+			{
+				visit(probe_row, no_row, built.next, build_partitions, build_begin);
+				continue;
+			}
+			visit(probe_row, *window_results[i], built.next, build_partitions, build_begin);
+		}
+	}
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+std::vector<typename PartitionedHashJoin<Key, Hash, KeyEqual>::Match>
+		PartitionedHashJoin<Key, Hash, KeyEqual>::inner_join(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count) const
+{
+	std::vector<Match> matches;
+	probe_partitions(build, build_count, probe, probe_count,
+		[&matches](row_type probe_row, row_type head, const std::vector<row_type>& next, const Partitions& partitions, size_type build_begin) {
+			for (row_type local = head; local != no_row; local = next[local])
+				matches.push_back({ partitions.rows[build_begin + local], probe_row });
+		});
+	return matches;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+std::vector<typename PartitionedHashJoin<Key, Hash, KeyEqual>::row_type>
+		PartitionedHashJoin<Key, Hash, KeyEqual>::semi_join(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count) const
+{
+	std::vector<row_type> rows;
+	probe_partitions(build, build_count, probe, probe_count,
+		[&rows](row_type probe_row, row_type head, const std::vector<row_type>&, const Partitions&, size_type) {
+			if (head != no_row)
+				rows.push_back(probe_row);
+		});
+	return rows;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+std::vector<typename PartitionedHashJoin<Key, Hash, KeyEqual>::row_type>
+		PartitionedHashJoin<Key, Hash, KeyEqual>::anti_join(const key_type* build, size_type build_count, const key_type* probe, size_type probe_count) const
+{
+	std::vector<row_type> rows;
+	probe_partitions(build, build_count, probe, probe_count,
+		[&rows](row_type probe_row, row_type head, const std::vector<row_type>&, const Partitions&, size_type) {
+			if (head == no_row)
+				rows.push_back(probe_row);
+		});
+	return rows;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+template<typename Value, typename Acc, typename Combine>
+std::vector<std::pair<typename PartitionedHashJoin<Key, Hash, KeyEqual>::key_type, Acc>>
+		PartitionedHashJoin<Key, Hash, KeyEqual>::group_by(const key_type* keys, const Value* values, size_type count, const Acc& init, Combine combine) const
+{
+	check_rows(count);
+
+	const unsigned bits = radix_bits_for(count);
+	const Partitions partitions = partition(keys, count, bits);
+
+	std::vector<std::pair<key_type, Acc>> groups;
+	for (size_type p = 0; p + 1 < partitions.offsets.size(); ++p)
+	{
+		const size_type begin = partitions.offsets[p];
+		const size_type end = partitions.offsets[p + 1];
+		if (begin == end)
+			continue;
+
+		// Each key maps to its group's position in the output vector.
+		table_type table = make_table((end - begin) * 4 / 3 + 1, _hash);
+		for (size_type i = begin; i < end; ++i)
+		{
+			const row_type row = partitions.rows[i];
+			const key_type& key = partitions.keys[i];
+			auto [it, inserted] = table.insert(key, static_cast<row_type>(groups.size()));
+			if (it == table.end())
+				throw std::length_error("PartitionedHashJoin group table has no free slot");
+			if (inserted)
+				groups.emplace_back(key, init);
+			combine(groups[it->second].second, values[row]);
+		}
+	}
+	return groups;
+}
+
+template<typename Key, typename Hash, typename KeyEqual>
+inline typename PartitionedHashJoin<Key, Hash, KeyEqual>::size_type PartitionedHashJoin<Key, Hash, KeyEqual>::partition_bytes() const noexcept
+{
+	return _partition_bytes;
+}
@@ -0,0 +1,509 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <functional>
+
+#include "ValuePool.h"
+#include "MemoryUsage.h"
+#include "LinearProbing.h"
+#include "OpenAddressingHashTable.h"
+
+// Mapped values live out of line in a ValuePool and the probed slots hold only the
+// key and a 32-bit pool index. Growth moves small slots, values are constructed in
+// place and never relocated, so references to mapped values survive rehash.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class PooledOpenAddressingHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using value_type = std::pair<const Key, T>;
+	using pool_type = ValuePool<T>;
+	using index_type = typename pool_type::index_type;
+	using index_table_type = OpenAddressingHashTable<Key, index_type, Hash, KeyEqual, ProbingStrategy>;
+	using probing_strategy_type = ProbingStrategy;
+
+private:
+	index_table_type _index;
+	pool_type _pool;
+
+public:
+	template<bool IsConst>
+	class HashIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::pair<const Key, T>;
+		using reference = std::pair<const Key&, std::conditional_t<IsConst, const T&, T&>>;
+
+		struct pointer
+		{
+			reference ref;
+			reference* operator->() { return &ref; }
+		};
+
+	private:
+		using index_iterator = std::conditional_t<IsConst, typename index_table_type::const_iterator, typename index_table_type::iterator>;
+		using pool_ptr = std::conditional_t<IsConst, const pool_type*, pool_type*>;
+
+		index_iterator _current;
+		pool_ptr _pool;
+
+	public:
+		HashIterator();
+		HashIterator(index_iterator current, pool_ptr pool);
+
+		reference operator*() const;
+		pointer operator->() const;
+
+		HashIterator& operator++();
+		HashIterator operator++(int);
+
+		bool operator==(const HashIterator& rhs) const;
+		bool operator!=(const HashIterator& rhs) const;
+	};
+
+	using iterator = HashIterator<false>;
+	using const_iterator = HashIterator<true>;
+
+
+	PooledOpenAddressingHashTable(size_type capacity = 16);
+	PooledOpenAddressingHashTable(std::initializer_list<value_type> init);
+	PooledOpenAddressingHashTable(size_type capacity, const hasher& hash, const key_equal& equal, const ProbingStrategy& strategy);
+	PooledOpenAddressingHashTable(const PooledOpenAddressingHashTable& other) = delete;
+	PooledOpenAddressingHashTable(PooledOpenAddressingHashTable&& other) noexcept = default;
+
+	PooledOpenAddressingHashTable& operator=(const PooledOpenAddressingHashTable& other) = delete;
+	PooledOpenAddressingHashTable& operator=(PooledOpenAddressingHashTable&& other) noexcept = default;
+
+	std::pair<iterator, bool> insert(const value_type& kv);
+	std::pair<iterator, bool> insert(value_type&& kv);
+	std::pair<iterator, bool> insert(const key_type& key, const mapped_type& value);
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args);
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj);
+
+	// Under linear probing erase() shifts other index slots, so it invalidates
+	// iterators; references to mapped values stay valid.
+	size_type erase(const key_type& key);
+
+	void clear();
+
+	mapped_type& operator[](const key_type& key);
+
+	mapped_type& at(const key_type& key);
+	const mapped_type& at(const key_type& key) const;
+
+	iterator find(const key_type& key);
+	const_iterator find(const key_type& key) const;
+
+	bool contains(const key_type& key) const;
+	size_type count(const key_type& key) const;
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+
+	size_type capacity() const noexcept;
+
+	float load_factor() const noexcept;
+	float max_load_factor() const noexcept;
+	void max_load_factor(float ml);
+	void reserve(size_type n);
+	void rehash(size_type new_capacity);
+
+	// The pool's chunks count as slots and its bookkeeping as metadata, on top
+	// of the index table's own breakdown.
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
+
+	void swap(PooledOpenAddressingHashTable& other) noexcept;
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::HashIterator()
+	: _current()
+	, _pool(nullptr)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::HashIterator(index_iterator current, pool_ptr pool)
+	: _current(current)
+	, _pool(pool)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>::reference
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator*() const
+{
+	return reference(_current->first, (*_pool)[_current->second]);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>::pointer
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator->() const
+{
+	return pointer{ **this };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>&
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator++()
+{
+	++_current;
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator++(int)
+{
+	HashIterator temp = *this;
+	++(*this);
+	return temp;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline bool PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::operator==(const HashIterator& rhs) const
+{
+	return _current == rhs._current;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline bool PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::operator!=(const HashIterator& rhs) const
+{
+	return _current != rhs._current;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::PooledOpenAddressingHashTable(size_type capacity)
+	: _index(capacity)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::PooledOpenAddressingHashTable(std::initializer_list<value_type> init)
+	: PooledOpenAddressingHashTable(init.size())
+{
+	for (const auto& elem : init)
+		insert(elem);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::PooledOpenAddressingHashTable(size_type capacity, const hasher& hash, const key_equal& equal, const ProbingStrategy& strategy)
+	: _index(capacity, hash, equal, strategy)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(const value_type& kv)
+{
+	return try_emplace(kv.first, kv.second);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(value_type&& kv)
+{
+	return try_emplace(kv.first, std::move(kv.second));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::insert(const key_type& key, const mapped_type& value)
+{
+	return try_emplace(key, value);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename... Args>
+inline std::pair<typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::try_emplace(const key_type& key, Args&&... args)
+{
+	auto [it, inserted] = _index.insert(key, index_type(0));
+	if (it == _index.end())
+		return { end(), false };
+
+	if (inserted)
+	{
+		try
+		{
+			it->second = _pool.emplace(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			_index.erase(key);
+			throw;
+		}
+	}
+
+	return { iterator(it, &_pool), inserted };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename M>
+inline std::pair<typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::insert_or_assign(const key_type& key, M&& obj)
+{
+	auto [it, inserted] = _index.insert(key, index_type(0));
+	if (it == _index.end())
+		return { end(), false };
+
+	if (inserted)
+	{
+		try
+		{
+			it->second = _pool.emplace(std::forward<M>(obj));
+		}
+		catch (...)
+		{
+			_index.erase(key);
+			throw;
+		}
+	}
+	else
+		_pool[it->second] = std::forward<M>(obj);
+
+	return { iterator(it, &_pool), inserted };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	auto it = _index.find(key);
+	if (it == _index.end())
+		return 0;
+
+	_pool.destroy(it->second);
+	return _index.erase(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	_index.clear();
+	_pool.clear();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::operator[](const key_type& key)
+{
+	auto result = try_emplace(key);
+	// No free slot on the index's probe path: grow, which also drops tombstones, and retry.
+	if (result.first == end())
+	{
+		rehash(capacity() == 0 ? 16 : capacity() * 2);
+		return (*this)[key];
+	}
+	return result.first->second;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key)
+{
+	return _pool[_index.at(key)];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+const typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key) const
+{
+	return _pool[_index.at(key)];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key)
+{
+	return iterator(_index.find(key), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key) const
+{
+	return const_iterator(_index.find(key), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key) const
+{
+	return _index.contains(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::count(const key_type& key) const
+{
+	return _index.count(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size() const noexcept
+{
+	return _index.size();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::empty() const noexcept
+{
+	return _index.empty();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::capacity() const noexcept
+{
+	return _index.capacity();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+float PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::load_factor() const noexcept
+{
+	return _index.load_factor();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+float PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::max_load_factor() const noexcept
+{
+	return _index.max_load_factor();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::max_load_factor(float ml)
+{
+	_index.max_load_factor(ml);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::reserve(size_type n)
+{
+	_index.reserve(n);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::rehash(size_type new_capacity)
+{
+	_index.rehash(new_capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+MemoryUsage PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Sizer>
+MemoryUsage PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage = _index.memory_usage([&](const key_type& key, index_type index) { return sizer(key, _pool[index]); });
+	usage.object_bytes = sizeof(*this);
+	usage.slot_bytes += _pool.slot_bytes();
+	usage.metadata_bytes += _pool.metadata_bytes();
+	usage.payload_bytes = size() * (sizeof(key_type) + sizeof(mapped_type)) + usage.external_bytes;
+	return usage;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::begin()
+{
+	return iterator(_index.begin(), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::end()
+{
+	return iterator(_index.end(), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::begin() const
+{
+	return const_iterator(_index.begin(), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::end() const
+{
+	return const_iterator(_index.end(), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::cbegin() const
+{
+	return const_iterator(_index.cbegin(), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::cend() const
+{
+	return const_iterator(_index.cend(), &_pool);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void PooledOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::swap(PooledOpenAddressingHashTable& other) noexcept
+{
+	_index.swap(other._index);
+	std::swap(_pool, other._pool);
+}
+
+template<typename K, typename M, typename H, typename E, typename P>
+inline void swap(PooledOpenAddressingHashTable<K, M, H, E, P>& lhs, PooledOpenAddressingHashTable<K, M, H, E, P>& rhs) noexcept
+{
+	lhs.swap(rhs);
+}
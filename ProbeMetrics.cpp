@@ -0,0 +1,252 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ProbeStatistics.h"
+#include "ConstexprHashTable.h"
+#include "OpenAddressingHashTable.h"
+#include "LinearProbing.h"
+#include "QuadraticProbing.h"
+#include "DoubleHashing.h"
+#include "TriangularProbing.h"
+
+// Prints machine-independent cost metrics (probes, longest probe sequence, key
+// comparisons, heap allocations) for each probing strategy over fixed seeded key
+// sets and compares them with the expected values below. Any difference, lost
+// insert or wrong lookup exits non-zero, so algorithmic regressions in
+// find_index(), probe_insert_slot(), erase() and rehash() fail the run without
+// wall-clock noise. After an intended change, paste the new output into
+// expected_metrics.
+//
+// Keys are hashed with ConstexprHash so the mixing does not depend on the
+// platform's std::hash. DoubleHashing still derives its step from std::hash, so
+// its rows are only compared where std::hash<std::uint64_t> is the identity.
+
+namespace
+{
+    std::size_t allocation_count = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocation_count;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++allocation_count;
+    const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+    if (void* p = _aligned_malloc(size == 0 ? 1 : size, align))
+        return p;
+#else
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#ifdef _MSC_VER
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+namespace
+{
+    using metric_key = std::uint64_t;
+    using metric_value = std::uint64_t;
+
+    constexpr std::size_t key_count = 20000;
+    constexpr std::uint64_t seed = 0x5EED;
+
+    // Raw mt19937_64 output is specified by the standard; distributions are not,
+    // so keys are taken straight from the engine.
+    std::vector<metric_key> make_keys(std::uint64_t key_seed, std::size_t count)
+    {
+        std::mt19937_64 engine(key_seed);
+        std::vector<metric_key> keys(count);
+        for (metric_key& key : keys)
+            key = engine();
+        return keys;
+    }
+
+    struct PhaseMetrics
+    {
+        ProbeStatistics probes;
+        std::size_t allocations = 0;
+        std::size_t results = 0;
+    };
+
+    struct ExpectedMetrics
+    {
+        const char* strategy;
+        const char* phase;
+        std::size_t sequences;
+        std::size_t probes;
+        std::size_t max_probe;
+        std::size_t comparisons;
+        std::size_t allocations;
+        std::size_t results;
+    };
+
+    // Output of this program at the last intended change.
+    constexpr ExpectedMetrics expected_metrics[] = {
+        { "linear", "insert", 44575, 95859, 67, 51284, 13, 20000 },
+        { "linear", "find_hit", 20000, 35914, 50, 35914, 0, 20000 },
+        { "linear", "find_miss", 20000, 74222, 56, 54222, 0, 0 },
+        { "linear", "erase_half_find", 30000, 40029, 11, 30029, 0, 10000 },
+        { "linear", "rehash", 10000, 10966, 5, 966, 1, 10000 },
+        { "quadratic", "insert", 44575, 80446, 26, 35871, 13, 20000 },
+        { "quadratic", "find_hit", 20000, 32333, 25, 32333, 0, 20000 },
+        { "quadratic", "find_miss", 20000, 54881, 26, 34881, 0, 0 },
+        { "quadratic", "erase_half_find", 30000, 77866, 29, 39191, 0, 10000 },
+        { "quadratic", "rehash", 10000, 10931, 5, 931, 1, 10000 },
+        { "double", "insert", 44575, 77160, 24, 32585, 13, 20000 },
+        { "double", "find_hit", 20000, 31239, 17, 31239, 0, 20000 },
+        { "double", "find_miss", 20000, 51710, 21, 31710, 0, 0 },
+        { "double", "erase_half_find", 30000, 72850, 25, 36535, 0, 10000 },
+        { "double", "rehash", 10000, 10912, 7, 912, 1, 10000 },
+        { "triangular", "insert", 44575, 81530, 26, 36955, 13, 20000 },
+        { "triangular", "find_hit", 20000, 32620, 17, 32620, 0, 20000 },
+        { "triangular", "find_miss", 20000, 56839, 23, 36839, 0, 0 },
+        { "triangular", "erase_half_find", 30000, 79381, 23, 39804, 0, 10000 },
+        { "triangular", "rehash", 10000, 10963, 7, 963, 1, 10000 },
+    };
+
+    bool std_hash_is_identity()
+    {
+        const std::hash<metric_key> hash;
+        return hash(0) == 0 && hash(1) == 1 && hash(0x5EED) == 0x5EED;
+    }
+
+    // Reports a difference to stderr and returns false; a missing row counts as one.
+    bool check(const std::string& strategy, const std::string& phase, const PhaseMetrics& metrics)
+    {
+        if (strategy == "double" && !std_hash_is_identity())
+            return true;
+
+        for (const ExpectedMetrics& expected : expected_metrics)
+        {
+            if (strategy != expected.strategy || phase != expected.phase)
+                continue;
+
+            const bool matches = metrics.probes.sequences == expected.sequences
+                && metrics.probes.probes == expected.probes
+                && metrics.probes.max_probe_length == expected.max_probe
+                && metrics.probes.equality_comparisons == expected.comparisons
+                && metrics.allocations == expected.allocations
+                && metrics.results == expected.results;
+            if (!matches)
+                std::cerr << strategy << ' ' << phase << ": metrics differ from the expected values\n";
+            return matches;
+        }
+
+        std::cerr << strategy << ' ' << phase << ": no expected metrics\n";
+        return false;
+    }
+
+    void print(const std::string& strategy, const std::string& phase, const PhaseMetrics& metrics)
+    {
+        std::cout << strategy << ' ' << phase
+                  << " sequences=" << metrics.probes.sequences
+                  << " probes=" << metrics.probes.probes
+                  << " max_probe=" << metrics.probes.max_probe_length
+                  << " comparisons=" << metrics.probes.equality_comparisons
+                  << " allocations=" << metrics.allocations
+                  << " results=" << metrics.results << '\n';
+    }
+
+    template<typename Strategy, typename... StrategyArgs>
+    bool measure(const std::string& name, StrategyArgs... strategy_args)
+    {
+        using strategy_type = CountingProbing<metric_key, Strategy>;
+        using equal_type = CountingKeyEqual<metric_key>;
+        using table_type = OpenAddressingHashTable<metric_key, metric_value, ConstexprHash<metric_key>, equal_type, strategy_type>;
+
+        const std::vector<metric_key> present = make_keys(seed, key_count);
+        const std::vector<metric_key> absent = make_keys(seed + 1, key_count);
+
+        ProbeStatistics stats;
+        PhaseMetrics phase;
+        bool metrics_match = true;
+
+        auto begin_phase = [&]() {
+            stats.reset();
+            phase.allocations = allocation_count;
+            phase.results = 0;
+        };
+        auto end_phase = [&](const std::string& label) {
+            phase.probes = stats;
+            phase.allocations = allocation_count - phase.allocations;
+            print(name, label, phase);
+            metrics_match = check(name, label, phase) && metrics_match;
+        };
+
+        begin_phase();
+        table_type table(16, ConstexprHash<metric_key>(), equal_type(stats), strategy_type(stats, strategy_args...));
+        // The keys are distinct, so every insert must succeed.
+        for (metric_key key : present)
+            phase.results += table.insert(key, key).second ? 1 : 0;
+        const std::size_t inserted = phase.results;
+        const bool none_lost = inserted == present.size();
+        end_phase("insert");
+
+        begin_phase();
+        for (metric_key key : present)
+            phase.results += table.contains(key) ? 1 : 0;
+        const bool hits_match = phase.results == inserted;
+        end_phase("find_hit");
+
+        begin_phase();
+        for (metric_key key : absent)
+            phase.results += table.contains(key) ? 1 : 0;
+        const bool misses_match = phase.results == 0;
+        end_phase("find_miss");
+
+        begin_phase();
+        std::size_t erased = 0;
+        for (std::size_t i = 0; i < present.size(); i += 2)
+            erased += table.erase(present[i]);
+        for (metric_key key : present)
+            phase.results += table.contains(key) ? 1 : 0;
+        const bool erase_matches = phase.results == inserted - erased;
+        end_phase("erase_half_find");
+
+        begin_phase();
+        table.rehash(table.capacity() * 2);
+        phase.results = table.size();
+        const bool rehash_matches = phase.results == inserted - erased;
+        end_phase("rehash");
+
+        if (!none_lost)
+            std::cerr << name << ": lost " << present.size() - inserted << " inserts\n";
+        if (!hits_match || !misses_match || !erase_matches || !rehash_matches)
+            std::cerr << name << ": lookups disagree with the inserted key set\n";
+        return metrics_match && none_lost && hits_match && misses_match && erase_matches && rehash_matches;
+    }
+}
+
+int main()
+{
+    bool ok = true;
+    ok = measure<LinearProbing<metric_key>>("linear") && ok;
+    // i + 2i^2 permutes the slots of a power-of-two table (odd linear, even
+    // quadratic coefficient); the default 1, 3 reaches only even offsets.
+    ok = measure<QuadraticProbing<metric_key>>("quadratic", std::size_t(1), std::size_t(2)) && ok;
+    ok = measure<DoubleHashing<metric_key>>("double", std::size_t(97)) && ok;
+    ok = measure<TriangularProbing<metric_key>>("triangular") && ok;
+    return ok ? 0 : 1;
+}
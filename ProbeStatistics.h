@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <functional>
+
+#include "ProbingStrategy.h"
+#include "LinearProbing.h"
+
+struct ProbeStatistics
+{
+	std::size_t sequences = 0;
+	std::size_t probes = 0;
+	std::size_t max_probe_length = 0;
+	std::size_t equality_comparisons = 0;
+
+	double average_probe_length() const noexcept
+	{
+		return sequences == 0 ? 0.0 : static_cast<double>(probes) / static_cast<double>(sequences);
+	}
+
+	void reset() noexcept
+	{
+		*this = ProbeStatistics();
+	}
+};
+
+// Wraps a probing strategy and counts every slot position it hands out into an
+// external ProbeStatistics. Clones share the same counters, so the statistics
+// follow the copy a table keeps for itself.
+template<typename Key, typename Strategy>
+class CountingProbing : public Strategy
+{
+private:
+	ProbeStatistics* _stats;
+
+public:
+	template<typename... Args>
+	explicit CountingProbing(ProbeStatistics& stats, Args&&... args)
+		: Strategy(std::forward<Args>(args)...)
+		, _stats(&stats)
+	{
+	}
+
+	// Tables start every sequence with probe(attempt = 0) and continue through
+	// next(); a probe() with attempt > 0 is the base next() recomputing and has
+	// already been counted there.
+	std::size_t probe(const Key& key, std::size_t hash, std::size_t attempt, std::size_t capacity) const override
+	{
+		if (attempt == 0)
+		{
+			++_stats->sequences;
+			record(attempt);
+		}
+		return Strategy::probe(key, hash, attempt, capacity);
+	}
+
+	std::size_t next(const Key& key, std::size_t hash, std::size_t attempt, std::size_t previous, std::size_t capacity) const override
+	{
+		record(attempt);
+		return Strategy::next(key, hash, attempt, previous, capacity);
+	}
+
+	IProbingStrategy<Key>* clone() const override
+	{
+		return new CountingProbing(*this);
+	}
+
+private:
+	void record(std::size_t attempt) const noexcept
+	{
+		++_stats->probes;
+		if (attempt + 1 > _stats->max_probe_length)
+			_stats->max_probe_length = attempt + 1;
+	}
+};
+
+// Counting does not change the sequence, so backward-shift deletion stays valid.
+template<typename Key, typename Strategy>
+struct is_linear_probing<CountingProbing<Key, Strategy>> : is_linear_probing<Strategy> {};
+
+template<typename Key, typename Strategy>
+struct unwrapped_probing<CountingProbing<Key, Strategy>> : unwrapped_probing<Strategy> {};
+
+// Key comparator that counts its calls into the same ProbeStatistics, so probe
+// counts and the key comparisons they cost can be read side by side.
+template<typename Key, typename KeyEqual = std::equal_to<Key>>
+class CountingKeyEqual
+{
+private:
+	ProbeStatistics* _stats;
+	KeyEqual _equal;
+
+public:
+	explicit CountingKeyEqual(ProbeStatistics& stats, const KeyEqual& equal = KeyEqual())
+		: _stats(&stats)
+		, _equal(equal)
+	{
+	}
+
+	bool operator()(const Key& lhs, const Key& rhs) const
+	{
+		++_stats->equality_comparisons;
+		return _equal(lhs, rhs);
+	}
+};
@@ -10,5 +10,16 @@ public:
 
 	virtual std::size_t probe(const Key& key, std::size_t hash, std::size_t attempt, std::size_t capacity) const = 0;
 
+	// Probe position for attempt > 0 given the position of attempt - 1; strategies
+	// with a cheap recurrence override this to avoid recomputing from scratch.
+	virtual std::size_t next(const Key& key, std::size_t hash, std::size_t attempt, std::size_t /*previous*/, std::size_t capacity) const
+	{
+		return probe(key, hash, attempt, capacity);
+	}
+
+	virtual std::size_t adjust_capacity(std::size_t capacity) const { return capacity; }
+
+	virtual void set_capacity(std::size_t /*capacity*/) {}
+
 	virtual IProbingStrategy* clone() const = 0;
 };
\ No newline at end of file
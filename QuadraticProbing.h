@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ProbingStrategy.h"
+#include "FastModulo.h"
 
 template<typename Key>
 class QuadraticProbing : public IProbingStrategy<Key>
@@ -8,6 +9,7 @@ class QuadraticProbing : public IProbingStrategy<Key>
 private:
 	std::size_t _c1;
 	std::size_t _c2;
+	FastModulo _modulo;
 public:
 	QuadraticProbing(std::size_t c1 = 1, std::size_t c2 = 3)
 		: _c1(c1)
@@ -17,11 +19,16 @@ public:
 
 	std::size_t probe(const Key& /*key*/, std::size_t hash, std::size_t attempt, std::size_t capacity) const override
 	{
-		return (hash + _c1 * attempt + _c2 * attempt * attempt) % capacity;
+		return _modulo.reduce(hash + _c1 * attempt + _c2 * attempt * attempt, capacity);
+	}
+
+	void set_capacity(std::size_t capacity) override
+	{
+		_modulo = FastModulo(capacity);
 	}
 
 	IProbingStrategy<Key>* clone() const override
 	{
-		return new QuadraticProbing<Key>(_c1, _c2);
+		return new QuadraticProbing<Key>(*this);
 	}
 };
\ No newline at end of file
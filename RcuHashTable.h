@@ -0,0 +1,247 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <optional>
+#include <functional>
+
+#include "EpochReclaimer.h"
+#include "LinearProbing.h"
+#include "OpenAddressingHashTable.h"
+
+// Read-copy-update map for read-mostly data. Readers load the current immutable
+// snapshot through an atomic pointer and take no locks; writers copy the snapshot,
+// modify the copy and publish it with one atomic store, then retire the old one
+// through epoch-based reclamation. A write costs O(n), so this fits tables that
+// are read millions of times per write.
+//
+// The fast read path is a Reader handle, which owns a reclaimer slot for its
+// lifetime; find() and contains() on the map claim a slot per call.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class RcuHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using snapshot_type = OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>;
+
+private:
+	std::atomic<const snapshot_type*> _current;
+	mutable std::mutex _write_mutex;
+	// Readers only write their own slot, so reading is logically const.
+	mutable EpochReclaimer _reclaimer;
+
+public:
+	class Reader
+	{
+	private:
+		const RcuHashTable* _table;
+		std::size_t _slot;
+
+	public:
+		explicit Reader(const RcuHashTable& table);
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+		~Reader();
+
+		std::optional<mapped_type> find(const key_type& key) const;
+		bool contains(const key_type& key) const;
+		size_type size() const;
+
+		// Calls fn(const snapshot_type&) on one consistent snapshot.
+		template<typename Fn>
+		decltype(auto) read(Fn&& fn) const;
+	};
+
+	explicit RcuHashTable(size_type capacity = 16, size_type max_readers = 64);
+
+	RcuHashTable(const RcuHashTable&) = delete;
+	RcuHashTable& operator=(const RcuHashTable&) = delete;
+	~RcuHashTable();
+
+	Reader reader() const;
+
+	std::optional<mapped_type> find(const key_type& key) const;
+	bool contains(const key_type& key) const;
+	size_type size() const;
+
+	bool insert(const key_type& key, const mapped_type& value);
+	bool insert_or_assign(const key_type& key, const mapped_type& value);
+	size_type erase(const key_type& key);
+	void clear();
+
+	// Applies fn(snapshot_type&) to a private copy and publishes the result as
+	// one update, so a batch of changes costs one copy.
+	template<typename Fn>
+	void update(Fn&& fn);
+
+	size_type pending_reclamation() const;
+
+private:
+	void publish(snapshot_type* next);
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader::Reader(const RcuHashTable& table)
+	: _table(&table)
+	, _slot(table._reclaimer.acquire_slot())
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader::~Reader()
+{
+	_table->_reclaimer.release_slot(_slot);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Fn>
+inline decltype(auto) RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader::read(Fn&& fn) const
+{
+	struct Section
+	{
+		EpochReclaimer& reclaimer;
+		std::size_t slot;
+		~Section() { reclaimer.exit(slot); }
+	};
+
+	EpochReclaimer& reclaimer = _table->_reclaimer;
+	reclaimer.enter(_slot);
+	Section section{ reclaimer, _slot };
+	return std::forward<Fn>(fn)(*_table->_current.load(std::memory_order_seq_cst));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader::find(const key_type& key) const
+{
+	return read([&key](const snapshot_type& snapshot) -> std::optional<mapped_type> {
+		auto it = snapshot.find(key);
+		if (it == snapshot.end())
+			return std::nullopt;
+		return it->second;
+	});
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader::contains(const key_type& key) const
+{
+	return read([&key](const snapshot_type& snapshot) { return snapshot.contains(key); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader::size() const
+{
+	return read([](const snapshot_type& snapshot) { return snapshot.size(); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::RcuHashTable(size_type capacity, size_type max_readers)
+	: _current(new snapshot_type(capacity))
+	, _reclaimer(max_readers)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::~RcuHashTable()
+{
+	delete _current.load(std::memory_order_relaxed);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Reader
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::reader() const
+{
+	return Reader(*this);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key) const
+{
+	return Reader(*this).find(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key) const
+{
+	return Reader(*this).contains(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size() const
+{
+	return Reader(*this).size();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Fn>
+void RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::update(Fn&& fn)
+{
+	std::lock_guard lock(_write_mutex);
+	// Only writers replace _current and they hold the mutex, so the snapshot read
+	// here stays alive without entering an epoch.
+	std::unique_ptr<snapshot_type> next(new snapshot_type(*_current.load(std::memory_order_acquire)));
+	std::forward<Fn>(fn)(*next);
+	publish(next.release());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(const key_type& key, const mapped_type& value)
+{
+	bool inserted = false;
+	update([&](snapshot_type& snapshot) { inserted = snapshot.insert(key, value).second; });
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert_or_assign(const key_type& key, const mapped_type& value)
+{
+	bool inserted = false;
+	update([&](snapshot_type& snapshot) { inserted = snapshot.insert_or_assign(key, value).second; });
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	size_type erased = 0;
+	update([&](snapshot_type& snapshot) { erased = snapshot.erase(key); });
+	return erased;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	std::lock_guard lock(_write_mutex);
+	publish(new snapshot_type(_current.load(std::memory_order_acquire)->capacity()));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::publish(snapshot_type* next)
+{
+	const snapshot_type* previous = _current.exchange(next, std::memory_order_seq_cst);
+	_reclaimer.retire(const_cast<snapshot_type*>(previous));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		RcuHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::pending_reclamation() const
+{
+	std::lock_guard lock(_write_mutex);
+	return _reclaimer.pending();
+}
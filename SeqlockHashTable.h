@@ -0,0 +1,486 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <type_traits>
+
+#include "Bucket.h"
+
+// Fixed-capacity concurrent table for small trivially copyable keys and values.
+// Slots are grouped eight to a cache-line-aligned group that carries a sequence
+// counter. Readers copy slots optimistically and retry the group if its sequence
+// changed underneath them, so lookups never write shared memory. Writers are
+// serialised by one mutex and bump a group's sequence around each slot write.
+//
+// Probing is linear over the slot array rather than a pluggable strategy:
+// readers validate a contiguous run of slots per group, which only a linear
+// sequence provides. Like StaticOpenAddressingHashTable the table never grows;
+// insert() returns false once no slot is left. Erase leaves a tombstone, since
+// shifting an element back could move it past a reader that already validated
+// its group. Tombstones are purged by rebuilding the slot array in place once
+// they reach a quarter of the capacity, or on demand through purge(); readers
+// spin for the length of a rebuild.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>
+>
+class SeqlockHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+
+	static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<T>,
+		"SeqlockHashTable copies keys and values optimistically and needs trivially copyable types");
+	static_assert(sizeof(Key) + sizeof(T) <= 48, "SeqlockHashTable is meant for values of a few words");
+
+	static constexpr size_type group_size = 8;
+
+private:
+	using word_type = std::uint64_t;
+
+	static constexpr size_type key_words = (sizeof(Key) + sizeof(word_type) - 1) / sizeof(word_type);
+	static constexpr size_type value_words = (sizeof(T) + sizeof(word_type) - 1) / sizeof(word_type);
+
+	// Every field is an atomic word so optimistic reads racing a writer are
+	// well-defined; the sequence check decides whether the copy is used.
+	struct Slot
+	{
+		std::atomic<word_type> state{ static_cast<word_type>(BucketState::EMPTY) };
+		std::atomic<word_type> key[key_words];
+		std::atomic<word_type> value[value_words];
+	};
+
+	struct alignas(64) Group
+	{
+		std::atomic<std::uint64_t> sequence{ 0 };
+		Slot slots[group_size];
+	};
+
+	std::unique_ptr<Group[]> _groups;
+	size_type _capacity;
+	size_type _mask;
+	std::atomic<size_type> _size{ 0 };
+	std::mutex _write_mutex;
+	// Guarded by _write_mutex.
+	size_type _tombstones = 0;
+	// Bumped by every purge while all groups are odd. A purge can move a key into
+	// a group a reader has already validated, so readers restart if it changed.
+	std::atomic<std::uint64_t> _purges{ 0 };
+
+	hasher _hash;
+	key_equal _equal;
+
+public:
+	explicit SeqlockHashTable(size_type capacity = 1024, const hasher& hash = hasher(), const key_equal& equal = key_equal());
+
+	SeqlockHashTable(const SeqlockHashTable&) = delete;
+	SeqlockHashTable& operator=(const SeqlockHashTable&) = delete;
+
+	bool insert(const key_type& key, const mapped_type& value);
+	bool insert_or_assign(const key_type& key, const mapped_type& value);
+	size_type erase(const key_type& key);
+	void clear();
+
+	// Rebuilds the slots without tombstones. Every group is held mid-write for
+	// the duration, so concurrent readers wait rather than see a partial array.
+	void purge();
+
+	std::optional<mapped_type> find(const key_type& key) const;
+	bool contains(const key_type& key) const;
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+	bool full() const noexcept;
+	size_type capacity() const noexcept;
+
+private:
+	Slot& slot_at(size_type index) const noexcept;
+	Group& group_of(size_type index) const noexcept;
+
+	template<typename U, size_type Words>
+	static void store_words(std::atomic<word_type> (&words)[Words], const U& object) noexcept;
+	template<typename U, size_type Words>
+	static U load_words(const std::atomic<word_type> (&words)[Words]) noexcept;
+
+	static BucketState state_of(const Slot& slot) noexcept;
+
+	// Writer-side probe, under _write_mutex: slot holding key, else first reusable
+	// slot on its path, else _capacity.
+	std::pair<size_type, bool> probe_insert_slot(const key_type& key) const;
+	size_type find_index(const key_type& key) const;
+	std::optional<mapped_type> probe_groups(const key_type& key) const;
+
+	void begin_write(Group& group) noexcept;
+	void end_write(Group& group) noexcept;
+	void write_slot(size_type index, BucketState state, const key_type* key, const mapped_type* value) noexcept;
+	void purge_locked();
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline SeqlockHashTable<Key, T, Hash, KeyEqual>::SeqlockHashTable(size_type capacity, const hasher& hash, const key_equal& equal)
+	: _hash(hash)
+	, _equal(equal)
+{
+	size_type rounded = group_size;
+	while (rounded < capacity)
+		rounded <<= 1;
+
+	_groups.reset(new Group[rounded / group_size]);
+	_capacity = rounded;
+	_mask = rounded - 1;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline typename SeqlockHashTable<Key, T, Hash, KeyEqual>::Slot&
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::slot_at(size_type index) const noexcept
+{
+	return _groups[index / group_size].slots[index % group_size];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline typename SeqlockHashTable<Key, T, Hash, KeyEqual>::Group&
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::group_of(size_type index) const noexcept
+{
+	return _groups[index / group_size];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename U, std::size_t Words>
+inline void SeqlockHashTable<Key, T, Hash, KeyEqual>::store_words(std::atomic<word_type> (&words)[Words], const U& object) noexcept
+{
+	word_type buffer[Words] = {};
+	std::memcpy(buffer, &object, sizeof(U));
+	for (size_type i = 0; i < Words; ++i)
+		words[i].store(buffer[i], std::memory_order_relaxed);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename U, std::size_t Words>
+inline U SeqlockHashTable<Key, T, Hash, KeyEqual>::load_words(const std::atomic<word_type> (&words)[Words]) noexcept
+{
+	word_type buffer[Words];
+	for (size_type i = 0; i < Words; ++i)
+		buffer[i] = words[i].load(std::memory_order_relaxed);
+
+	// Copy into raw storage: trivially copyable is enough, U need not be default-constructible.
+	alignas(U) unsigned char storage[sizeof(U)];
+	std::memcpy(storage, buffer, sizeof(U));
+	return *std::launder(reinterpret_cast<const U*>(storage));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline BucketState SeqlockHashTable<Key, T, Hash, KeyEqual>::state_of(const Slot& slot) noexcept
+{
+	return static_cast<BucketState>(slot.state.load(std::memory_order_relaxed));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void SeqlockHashTable<Key, T, Hash, KeyEqual>::begin_write(Group& group) noexcept
+{
+	const std::uint64_t sequence = group.sequence.load(std::memory_order_relaxed);
+	group.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void SeqlockHashTable<Key, T, Hash, KeyEqual>::end_write(Group& group) noexcept
+{
+	group.sequence.store(group.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+inline void SeqlockHashTable<Key, T, Hash, KeyEqual>::write_slot(size_type index, BucketState state, const key_type* key, const mapped_type* value) noexcept
+{
+	Group& group = group_of(index);
+	Slot& slot = slot_at(index);
+
+	begin_write(group);
+	if (key)
+		store_words(slot.key, *key);
+	if (value)
+		store_words(slot.value, *value);
+	slot.state.store(static_cast<word_type>(state), std::memory_order_relaxed);
+	end_write(group);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+std::pair<typename SeqlockHashTable<Key, T, Hash, KeyEqual>::size_type, bool>
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::probe_insert_slot(const key_type& key) const
+{
+	size_type first_deleted_index = _capacity;
+	size_type index = _hash(key) & _mask;
+
+	for (size_type i = 0; i < _capacity; ++i, index = (index + 1) & _mask)
+	{
+		const Slot& slot = slot_at(index);
+		const BucketState state = state_of(slot);
+
+		if (state == BucketState::EMPTY)
+			return { (first_deleted_index != _capacity ? first_deleted_index : index), true };
+		else if (state == BucketState::DELETED)
+		{
+			if (first_deleted_index == _capacity)
+				first_deleted_index = index;
+		}
+		else if (_equal(load_words<Key>(slot.key), key))
+			return { index, false };
+	}
+
+	if (first_deleted_index != _capacity)
+		return { first_deleted_index, true };
+
+	return { _capacity, false };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename SeqlockHashTable<Key, T, Hash, KeyEqual>::size_type
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::find_index(const key_type& key) const
+{
+	auto [index, inserted] = probe_insert_slot(key);
+	return index != _capacity && !inserted ? index : _capacity;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool SeqlockHashTable<Key, T, Hash, KeyEqual>::insert(const key_type& key, const mapped_type& value)
+{
+	std::lock_guard lock(_write_mutex);
+	auto [index, inserted] = probe_insert_slot(key);
+	if (!inserted)
+		return false;
+
+	if (state_of(slot_at(index)) == BucketState::DELETED)
+		--_tombstones;
+	write_slot(index, BucketState::OCCUPIED, &key, &value);
+	_size.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool SeqlockHashTable<Key, T, Hash, KeyEqual>::insert_or_assign(const key_type& key, const mapped_type& value)
+{
+	std::lock_guard lock(_write_mutex);
+	auto [index, inserted] = probe_insert_slot(key);
+	if (index == _capacity)
+		return false;
+
+	if (inserted)
+	{
+		if (state_of(slot_at(index)) == BucketState::DELETED)
+			--_tombstones;
+		write_slot(index, BucketState::OCCUPIED, &key, &value);
+		_size.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+		write_slot(index, BucketState::OCCUPIED, nullptr, &value);
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename SeqlockHashTable<Key, T, Hash, KeyEqual>::size_type
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::erase(const key_type& key)
+{
+	std::lock_guard lock(_write_mutex);
+	const size_type index = find_index(key);
+	if (index == _capacity)
+		return 0;
+
+	write_slot(index, BucketState::DELETED, nullptr, nullptr);
+	_size.fetch_sub(1, std::memory_order_relaxed);
+
+	// Each rebuild clears at least capacity / 4 tombstones, so its O(capacity)
+	// cost amortises to O(1) per erase.
+	if (++_tombstones * 4 >= _capacity)
+		purge_locked();
+	return 1;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void SeqlockHashTable<Key, T, Hash, KeyEqual>::purge()
+{
+	std::lock_guard lock(_write_mutex);
+	if (_tombstones != 0)
+		purge_locked();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void SeqlockHashTable<Key, T, Hash, KeyEqual>::purge_locked()
+{
+	struct Entry
+	{
+		size_type home;
+		word_type key[key_words];
+		word_type value[value_words];
+	};
+
+	// Allocate before any group goes odd; if this throws, the table keeps its
+	// tombstones and stays usable.
+	std::vector<Entry> entries;
+	entries.reserve(_size.load(std::memory_order_relaxed));
+
+	const size_type group_count = _capacity / group_size;
+	for (size_type g = 0; g < group_count; ++g)
+		begin_write(_groups[g]);
+
+	for (size_type index = 0; index < _capacity; ++index)
+	{
+		Slot& slot = slot_at(index);
+		if (state_of(slot) == BucketState::OCCUPIED)
+		{
+			Entry entry;
+			entry.home = _hash(load_words<Key>(slot.key)) & _mask;
+			for (size_type i = 0; i < key_words; ++i)
+				entry.key[i] = slot.key[i].load(std::memory_order_relaxed);
+			for (size_type i = 0; i < value_words; ++i)
+				entry.value[i] = slot.value[i].load(std::memory_order_relaxed);
+			entries.push_back(entry);
+		}
+		slot.state.store(static_cast<word_type>(BucketState::EMPTY), std::memory_order_relaxed);
+	}
+
+	// Keys are distinct, so each one only needs the first empty slot on its path.
+	for (const Entry& entry : entries)
+	{
+		size_type index = entry.home;
+		while (state_of(slot_at(index)) != BucketState::EMPTY)
+			index = (index + 1) & _mask;
+
+		Slot& slot = slot_at(index);
+		for (size_type i = 0; i < key_words; ++i)
+			slot.key[i].store(entry.key[i], std::memory_order_relaxed);
+		for (size_type i = 0; i < value_words; ++i)
+			slot.value[i].store(entry.value[i], std::memory_order_relaxed);
+		slot.state.store(static_cast<word_type>(BucketState::OCCUPIED), std::memory_order_relaxed);
+	}
+
+	_purges.fetch_add(1, std::memory_order_relaxed);
+	for (size_type g = 0; g < group_count; ++g)
+		end_write(_groups[g]);
+	_tombstones = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void SeqlockHashTable<Key, T, Hash, KeyEqual>::clear()
+{
+	std::lock_guard lock(_write_mutex);
+	for (size_type g = 0; g < _capacity / group_size; ++g)
+	{
+		Group& group = _groups[g];
+		begin_write(group);
+		for (Slot& slot : group.slots)
+			slot.state.store(static_cast<word_type>(BucketState::EMPTY), std::memory_order_relaxed);
+		end_write(group);
+	}
+	_size.store(0, std::memory_order_relaxed);
+	_tombstones = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+std::optional<typename SeqlockHashTable<Key, T, Hash, KeyEqual>::mapped_type>
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::find(const key_type& key) const
+{
+	for (;;)
+	{
+		const std::uint64_t purges = _purges.load(std::memory_order_acquire);
+		std::optional<mapped_type> result = probe_groups(key);
+		if (_purges.load(std::memory_order_acquire) == purges)
+			return result;
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+std::optional<typename SeqlockHashTable<Key, T, Hash, KeyEqual>::mapped_type>
+		SeqlockHashTable<Key, T, Hash, KeyEqual>::probe_groups(const key_type& key) const
+{
+	size_type index = _hash(key) & _mask;
+
+	for (size_type probed = 0; probed < _capacity; )
+	{
+		const Group& group = group_of(index);
+		const size_type group_end = (index / group_size + 1) * group_size;
+
+		for (;;)
+		{
+			const std::uint64_t before = group.sequence.load(std::memory_order_acquire);
+			if (before & 1)
+				continue;
+
+			// 0: keep probing, 1: found, 2: absent.
+			int outcome = 0;
+			std::optional<mapped_type> value;
+			for (size_type i = index; i < group_end; ++i)
+			{
+				const Slot& slot = slot_at(i);
+				const BucketState state = state_of(slot);
+				if (state == BucketState::EMPTY)
+				{
+					outcome = 2;
+					break;
+				}
+				if (state == BucketState::OCCUPIED && _equal(load_words<Key>(slot.key), key))
+				{
+					value = load_words<T>(slot.value);
+					outcome = 1;
+					break;
+				}
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (group.sequence.load(std::memory_order_relaxed) != before)
+				continue;
+
+			if (outcome == 1)
+				return value;
+			if (outcome == 2)
+				return std::nullopt;
+			break;
+		}
+
+		probed += group_end - index;
+		index = group_end & _mask;
+	}
+	return std::nullopt;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool SeqlockHashTable<Key, T, Hash, KeyEqual>::contains(const key_type& key) const
+{
+	return find(key).has_value();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename SeqlockHashTable<Key, T, Hash, KeyEqual>::size_type SeqlockHashTable<Key, T, Hash, KeyEqual>::size() const noexcept
+{
+	return _size.load(std::memory_order_relaxed);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool SeqlockHashTable<Key, T, Hash, KeyEqual>::empty() const noexcept
+{
+	return size() == 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+bool SeqlockHashTable<Key, T, Hash, KeyEqual>::full() const noexcept
+{
+	return size() == _capacity;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+typename SeqlockHashTable<Key, T, Hash, KeyEqual>::size_type SeqlockHashTable<Key, T, Hash, KeyEqual>::capacity() const noexcept
+{
+	return _capacity;
+}
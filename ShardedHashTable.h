@@ -0,0 +1,733 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <shared_mutex>
+#include <system_error>
+
+#include "FastModulo.h"
+#include "NumaTopology.h"
+#include "LinearProbing.h"
+#include "OpenAddressingHashTable.h"
+
+// Thread-safe table split into independently locked shards. Every shard's bucket
+// array is placed on one NUMA node; shards are spread round-robin over the online
+// nodes. Keys are routed by hash across all shards (*_local variants route only
+// among the calling thread's node's shards, for data partitioned per node). On a
+// single-node machine no binding is attempted and both routings still work.
+//
+// A shard that reaches its load factor grows on a background thread: its table
+// is frozen and copied into a larger one while writes go to a side log that
+// readers consult first. The worker then takes the shard lock once to replay the
+// log and swap tables, so callers never wait on the O(n) copy itself; the old
+// table is released after the lock.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class ShardedHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using table_type = OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>;
+
+private:
+	using log_type = OpenAddressingHashTable<Key, std::optional<T>, Hash, KeyEqual, ProbingStrategy>;
+
+	// upsert() and fetch_add() update an existing key under the shard's read lock.
+	// Arithmetic values are then read and written with __atomic builtins; other
+	// values are guarded by one of value_stripes locks picked by slot address.
+	static constexpr bool atomic_values = std::is_arithmetic_v<T> && sizeof(T) <= sizeof(std::uint64_t);
+	static constexpr size_type value_stripes = atomic_values ? 0 : 64;
+
+	struct Migration
+	{
+		// Writes made since the table was frozen; nullopt marks an erase.
+		log_type log;
+		// Element count as readers see it: frozen table plus log.
+		size_type size = 0;
+		// clear() ran during the migration, so the frozen contents are gone.
+		bool cleared = false;
+		// The worker could not replay the log and exited. Log entries are
+		// idempotent, so the next write starts a new worker on the same log.
+		bool stalled = false;
+	};
+
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex mutex;
+		mutable std::array<std::mutex, value_stripes> stripes;
+		table_type table;
+		int node = 0;
+		std::unique_ptr<Migration> migration;
+		std::thread worker;
+
+		Shard(size_type capacity, int numa_node)
+			: table(capacity)
+			, node(numa_node)
+		{
+		}
+	};
+
+	struct NodeShards
+	{
+		std::vector<size_type> shards;
+		FastModulo modulo;
+	};
+
+	std::vector<std::unique_ptr<Shard>> _shards;
+	std::vector<NodeShards> _nodes;
+	FastModulo _shard_modulo;
+	hasher _hash;
+
+public:
+	explicit ShardedHashTable(size_type shards_per_node = 4, size_type shard_capacity = 16);
+
+	ShardedHashTable(const ShardedHashTable&) = delete;
+	ShardedHashTable& operator=(const ShardedHashTable&) = delete;
+	~ShardedHashTable();
+
+	bool insert(const key_type& key, const mapped_type& value);
+	bool insert_or_assign(const key_type& key, const mapped_type& value);
+	std::optional<mapped_type> find(const key_type& key) const;
+	bool contains(const key_type& key) const;
+	size_type erase(const key_type& key);
+
+	// Inserts init when key is absent, otherwise calls combine(mapped_type&) on
+	// the stored value, and returns the value now stored. An existing key is
+	// combined in place under the shard's read lock, so readers are not blocked:
+	// atomically for arithmetic types, where combine may run again if another
+	// thread changed the value first, and under a lock stripe otherwise. Only an
+	// insertion takes the write lock, and it probes once, so concurrent upserts of
+	// a key never race between lookup and insertion.
+	template<typename Combine>
+	mapped_type upsert(const key_type& key, const mapped_type& init, Combine&& combine);
+
+	// Adds delta to the value for key, starting from mapped_type() when absent,
+	// and returns the previous value. Arithmetic mapped types only; an existing
+	// integer is updated with a single __atomic_fetch_add.
+	mapped_type fetch_add(const key_type& key, const mapped_type& delta);
+
+	bool insert_local(const key_type& key, const mapped_type& value);
+	std::optional<mapped_type> find_local(const key_type& key) const;
+	size_type erase_local(const key_type& key);
+
+	void clear();
+	size_type size() const;
+	bool empty() const;
+
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+	size_type shard_count() const noexcept;
+	int shard_node(size_type shard) const noexcept;
+	size_type shard_index(const key_type& key) const;
+	size_type local_shard_index(const key_type& key) const;
+
+	// Blocks until no shard has a background migration running.
+	void wait_for_migrations();
+
+private:
+	static std::size_t route_hash(std::size_t hash) noexcept;
+	Shard& shard_at(size_type index) const noexcept;
+
+	static bool insert_into(Shard& shard, const key_type& key, const mapped_type& value, bool assign);
+	template<typename Combine>
+	static mapped_type upsert_into(Shard& shard, const key_type& key, const mapped_type& init, Combine& combine);
+	// upsert_into() for a key that was absent under the read lock.
+	template<typename Combine>
+	static mapped_type upsert_locked(Shard& shard, const key_type& key, const mapped_type& init, Combine& combine);
+	template<typename Combine>
+	static mapped_type combine_in_place(const Shard& shard, mapped_type& value, Combine& combine);
+	static mapped_type load_value(const Shard& shard, const mapped_type& value);
+	static std::mutex& stripe_for(const Shard& shard, const mapped_type& value) noexcept;
+	static std::optional<mapped_type> find_in(const Shard& shard, const key_type& key);
+	static bool contains_in(const Shard& shard, const key_type& key);
+	static bool contains_in_migration(const Shard& shard, const key_type& key);
+	static size_type erase_from(Shard& shard, const key_type& key);
+
+	static bool needs_growth(const table_type& table) noexcept;
+	static bool needs_migration(const Shard& shard) noexcept;
+	static void start_migration(Shard& shard);
+	static void migrate(Shard* shard, size_type capacity);
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::ShardedHashTable(size_type shards_per_node, size_type shard_capacity)
+	: _hash(Hash())
+{
+	const int node_count = NumaTopology::node_count();
+	const size_type total = (shards_per_node == 0 ? 1 : shards_per_node) * static_cast<size_type>(node_count);
+
+	_nodes.resize(static_cast<size_type>(node_count));
+	_shards.reserve(total);
+	for (size_type i = 0; i < total; ++i)
+	{
+		const int node = static_cast<int>(i % static_cast<size_type>(node_count));
+		_shards.emplace_back(new Shard(shard_capacity, node));
+		_nodes[static_cast<size_type>(node)].shards.push_back(i);
+
+		if (node_count > 1)
+		{
+			StoragePolicy policy = _shards.back()->table.storage_policy();
+			policy.numa_node = node;
+			_shards.back()->table.storage_policy(policy);
+		}
+	}
+
+	for (auto& node : _nodes)
+		node.modulo = FastModulo(node.shards.size());
+	_shard_modulo = FastModulo(total);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::~ShardedHashTable()
+{
+	wait_for_migrations();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline std::size_t ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::route_hash(std::size_t hash) noexcept
+{
+	// The shard tables reduce the low bits of the same hash, so route on a mixed
+	// value to keep shard choice and in-shard position independent.
+	return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::Shard&
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::shard_at(size_type index) const noexcept
+{
+	return *_shards[index];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::shard_index(const key_type& key) const
+{
+	return _shard_modulo(route_hash(_hash(key)));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::local_shard_index(const key_type& key) const
+{
+	const NodeShards& node = _nodes[static_cast<size_type>(NumaTopology::current_node())];
+	return node.shards[node.modulo(route_hash(_hash(key)))];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(const key_type& key, const mapped_type& value)
+{
+	return insert_into(shard_at(shard_index(key)), key, value, false);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert_or_assign(const key_type& key, const mapped_type& value)
+{
+	return insert_into(shard_at(shard_index(key)), key, value, true);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key) const
+{
+	return find_in(shard_at(shard_index(key)), key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key) const
+{
+	return contains_in(shard_at(shard_index(key)), key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	return erase_from(shard_at(shard_index(key)), key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Combine>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::upsert(const key_type& key, const mapped_type& init, Combine&& combine)
+{
+	return upsert_into(shard_at(shard_index(key)), key, init, combine);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::fetch_add(const key_type& key, const mapped_type& delta)
+{
+	static_assert(std::is_arithmetic_v<mapped_type>, "fetch_add needs an arithmetic mapped_type");
+
+	Shard& shard = shard_at(shard_index(key));
+	mapped_type previous = mapped_type();
+	auto add = [&](mapped_type& value) {
+		previous = value;
+		value += delta;
+	};
+
+	if constexpr (atomic_values && std::is_integral_v<mapped_type> && !std::is_same_v<mapped_type, bool>)
+	{
+		{
+			std::shared_lock lock(shard.mutex);
+			if (!shard.migration)
+			{
+				auto it = shard.table.find(key);
+				if (it != shard.table.end())
+					return __atomic_fetch_add(&it->second, delta, __ATOMIC_RELAXED);
+			}
+		}
+		upsert_locked(shard, key, delta, add);
+	}
+	else
+		upsert_into(shard, key, delta, add);
+	return previous;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert_local(const key_type& key, const mapped_type& value)
+{
+	return insert_into(shard_at(local_shard_index(key)), key, value, false);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find_local(const key_type& key) const
+{
+	return find_in(shard_at(local_shard_index(key)), key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase_local(const key_type& key)
+{
+	return erase_from(shard_at(local_shard_index(key)), key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	for (auto& shard : _shards)
+	{
+		std::unique_lock lock(shard->mutex);
+		if (shard->migration)
+		{
+			// The frozen table belongs to the worker until switchover.
+			shard->migration->log.clear();
+			shard->migration->size = 0;
+			shard->migration->cleared = true;
+		}
+		else
+			shard->table.clear();
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size() const
+{
+	size_type total = 0;
+	for (const auto& shard : _shards)
+	{
+		std::shared_lock lock(shard->mutex);
+		total += shard->migration ? shard->migration->size : shard->table.size();
+	}
+	return total;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::empty() const
+{
+	return size() == 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+MemoryUsage ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Sizer>
+MemoryUsage ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage;
+	usage.object_bytes = sizeof(*this) + _shards.capacity() * sizeof(std::unique_ptr<Shard>);
+	for (const auto& shard : _shards)
+	{
+		// The write lock keeps sizer off values that upsert() updates under the read lock.
+		std::unique_lock lock(shard->mutex);
+		usage += shard->table.memory_usage(sizer);
+		if (shard->migration)
+		{
+			usage += shard->migration->log.memory_usage([&sizer](const key_type& key, const std::optional<mapped_type>& value) {
+				return value ? sizer(key, *value) : size_type(0);
+			});
+		}
+		// The shard's table is already counted; add its mutex and padding.
+		usage.object_bytes += sizeof(Shard) - sizeof(table_type);
+	}
+	return usage;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::shard_count() const noexcept
+{
+	return _shards.size();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+int ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::shard_node(size_type shard) const noexcept
+{
+	return _shards[shard]->node;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::wait_for_migrations()
+{
+	for (auto& shard : _shards)
+	{
+		for (;;)
+		{
+			std::thread worker;
+			{
+				std::unique_lock lock(shard->mutex);
+				worker = std::move(shard->worker);
+			}
+			if (!worker.joinable())
+				break;
+			worker.join();
+		}
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert_into(Shard& shard, const key_type& key, const mapped_type& value, bool assign)
+{
+	std::unique_lock lock(shard.mutex);
+	if (needs_migration(shard))
+		start_migration(shard);
+
+	if (!shard.migration)
+		return assign ? shard.table.insert_or_assign(key, value).second : shard.table.insert(key, value).second;
+
+	Migration& migration = *shard.migration;
+	const bool exists = contains_in_migration(shard, key);
+	if (exists && !assign)
+		return false;
+
+	migration.log.insert_or_assign(key, std::optional<mapped_type>(value));
+	if (!exists)
+		++migration.size;
+	return !exists;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Combine>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::upsert_into(Shard& shard, const key_type& key, const mapped_type& init, Combine& combine)
+{
+	{
+		// A migration freezes the table, so in-place updates only happen without one.
+		std::shared_lock lock(shard.mutex);
+		if (!shard.migration)
+		{
+			auto it = shard.table.find(key);
+			if (it != shard.table.end())
+				return combine_in_place(shard, it->second, combine);
+		}
+	}
+
+	return upsert_locked(shard, key, init, combine);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Combine>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::upsert_locked(Shard& shard, const key_type& key, const mapped_type& init, Combine& combine)
+{
+	// The key may have been inserted since; the insert below then combines.
+	std::unique_lock lock(shard.mutex);
+	if (needs_migration(shard))
+		start_migration(shard);
+
+	if (!shard.migration)
+	{
+		auto [it, inserted] = shard.table.insert(key, init);
+		if (it == shard.table.end())
+		{
+			// No free slot on the probe path: grow inline and retry once.
+			shard.table.rehash(shard.table.capacity() == 0 ? 16 : shard.table.capacity() * 2);
+			std::tie(it, inserted) = shard.table.insert(key, init);
+			if (it == shard.table.end())
+				throw std::length_error("ShardedHashTable shard has no free slot");
+		}
+		if (!inserted)
+			combine(it->second);
+		return it->second;
+	}
+
+	// During a migration the current value lives in the log or the frozen table;
+	// the combined result goes to the log like any other write.
+	Migration& migration = *shard.migration;
+	std::optional<mapped_type> current;
+	auto logged = migration.log.find(key);
+	if (logged != migration.log.end())
+		current = logged->second;
+	else if (!migration.cleared)
+	{
+		auto it = shard.table.find(key);
+		if (it != shard.table.end())
+			current = it->second;
+	}
+
+	if (current)
+		combine(*current);
+	else
+	{
+		current = init;
+		++migration.size;
+	}
+	migration.log.insert_or_assign(key, current);
+	return *current;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Combine>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::combine_in_place(const Shard& shard, mapped_type& value, Combine& combine)
+{
+	if constexpr (atomic_values)
+	{
+		mapped_type expected;
+		__atomic_load(&value, &expected, __ATOMIC_RELAXED);
+		for (;;)
+		{
+			mapped_type desired = expected;
+			combine(desired);
+			if (__atomic_compare_exchange(&value, &expected, &desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				return desired;
+		}
+	}
+	else
+	{
+		std::lock_guard stripe(stripe_for(shard, value));
+		combine(value);
+		return value;
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::load_value(const Shard& shard, const mapped_type& value)
+{
+	// Pairs with combine_in_place(), which may be writing under the read lock too.
+	if constexpr (atomic_values)
+	{
+		mapped_type result;
+		__atomic_load(&value, &result, __ATOMIC_RELAXED);
+		return result;
+	}
+	else
+	{
+		std::lock_guard stripe(stripe_for(shard, value));
+		return value;
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline std::mutex& ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::stripe_for(const Shard& shard, const mapped_type& value) noexcept
+{
+	const std::uintptr_t slot = reinterpret_cast<std::uintptr_t>(&value) / sizeof(typename table_type::bucket_type);
+	return shard.stripes[slot % value_stripes];
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find_in(const Shard& shard, const key_type& key)
+{
+	std::shared_lock lock(shard.mutex);
+	if (shard.migration)
+	{
+		auto logged = shard.migration->log.find(key);
+		if (logged != shard.migration->log.end())
+			return logged->second;
+		if (shard.migration->cleared)
+			return std::nullopt;
+	}
+
+	auto it = shard.table.find(key);
+	if (it == shard.table.end())
+		return std::nullopt;
+	return load_value(shard, it->second);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains_in(const Shard& shard, const key_type& key)
+{
+	std::shared_lock lock(shard.mutex);
+	return shard.migration ? contains_in_migration(shard, key) : shard.table.contains(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains_in_migration(const Shard& shard, const key_type& key)
+{
+	auto logged = shard.migration->log.find(key);
+	if (logged != shard.migration->log.end())
+		return logged->second.has_value();
+	return !shard.migration->cleared && shard.table.contains(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase_from(Shard& shard, const key_type& key)
+{
+	std::unique_lock lock(shard.mutex);
+	if (!shard.migration)
+		return shard.table.erase(key);
+
+	if (!contains_in_migration(shard, key))
+		return 0;
+
+	shard.migration->log.insert_or_assign(key, std::optional<mapped_type>());
+	--shard.migration->size;
+	return 1;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::needs_growth(const table_type& table) noexcept
+{
+	// The insertion after this one would make the table rehash inline.
+	return static_cast<float>(table.size() + 1) > table.max_load_factor() * static_cast<float>(table.capacity());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::needs_migration(const Shard& shard) noexcept
+{
+	return shard.migration ? shard.migration->stalled : needs_growth(shard.table);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::start_migration(Shard& shard)
+{
+	// A finished worker has already released the shard, so joining it under the
+	// lock only waits for it to return.
+	if (shard.worker.joinable())
+		shard.worker.join();
+
+	const size_type capacity = shard.table.capacity() == 0 ? 16 : shard.table.capacity() * 2;
+	const bool resuming = static_cast<bool>(shard.migration);
+	if (!resuming)
+	{
+		shard.migration = std::make_unique<Migration>();
+		shard.migration->size = shard.table.size();
+	}
+	shard.migration->stalled = false;
+	try
+	{
+		shard.worker = std::thread(&ShardedHashTable::migrate, &shard, capacity);
+	}
+	catch (const std::system_error&)
+	{
+		// No thread available: grow inline as an unsharded table would. A stalled
+		// migration keeps its log and tries again on the next write.
+		if (resuming)
+			shard.migration->stalled = true;
+		else
+			shard.migration.reset();
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void ShardedHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::migrate(Shard* shard, size_type capacity)
+{
+	// shard->table is frozen until switchover: writers only touch the log, so it
+	// can be read here without the lock alongside shared-lock readers.
+	table_type target(0);
+	bool copied = true;
+	try
+	{
+		target.storage_policy(shard->table.storage_policy());
+		target.max_load_factor(shard->table.max_load_factor());
+		target.rehash(capacity);
+		for (const auto& [key, value] : shard->table)
+			target.insert(key, value);
+	}
+	catch (...)
+	{
+		// Out of memory for the copy: replay the log into the old table instead.
+		copied = false;
+	}
+
+	std::unique_lock lock(shard->mutex);
+	Migration& migration = *shard->migration;
+
+	auto replay = [&migration](table_type& destination) {
+		if (migration.cleared)
+			destination.clear();
+		for (auto& [key, value] : migration.log)
+		{
+			if (value)
+				destination.insert_or_assign(key, *value);
+			else
+				destination.erase(key);
+		}
+	};
+
+	// An exception must not reach std::terminate on this thread. Replaying into
+	// the copy falls back to the frozen table; if that fails too the migration
+	// stays in place, which readers still see correctly, and is retried.
+	if (copied)
+	{
+		try
+		{
+			replay(target);
+		}
+		catch (...)
+		{
+			copied = false;
+		}
+	}
+	if (!copied)
+	{
+		try
+		{
+			replay(shard->table);
+		}
+		catch (...)
+		{
+			migration.stalled = true;
+			return;
+		}
+	}
+
+	// Swap rather than move-assign: destroying the old table runs a destructor per
+	// slot and unmaps its block, which must not happen under the lock. The same
+	// goes for the log.
+	if (copied)
+		shard->table.swap(target);
+	std::unique_ptr<Migration> finished = std::move(shard->migration);
+	lock.unlock();
+}
@@ -0,0 +1,947 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <functional>
+
+#include "Bucket.h"
+#include "MemoryUsage.h"
+#include "ProbingStrategy.h"
+#include "LinearProbing.h"
+
+// Keys and mapped values live in parallel arrays, so probing streams only the key
+// array and a mapped value is touched once, after its key matched.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class SplitOpenAddressingHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using value_type = std::pair<const Key, T>;
+	using key_bucket_type = KeyBucket<Key>;
+	using probing_strategy_type = ProbingStrategy;
+	using base_probing_strategy_type = IProbingStrategy<Key>;
+
+private:
+	struct value_storage
+	{
+		alignas(T) unsigned char bytes[sizeof(T)];
+	};
+
+	std::unique_ptr<key_bucket_type[]> _keys;
+	std::unique_ptr<value_storage[]> _values;
+	size_type _capacity = 0;
+	size_type _size = 0;
+	float _max_load_factor = 0.75f;
+
+	hasher _hash;
+	key_equal _equal;
+	base_probing_strategy_type* _probing = nullptr;
+
+public:
+	template<bool IsConst>
+	class HashIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::pair<const Key, T>;
+		using reference = std::pair<const Key&, std::conditional_t<IsConst, const T&, T&>>;
+
+		struct pointer
+		{
+			reference ref;
+			reference* operator->() { return &ref; }
+		};
+
+	private:
+		using table_ptr = std::conditional_t<IsConst, const SplitOpenAddressingHashTable*, SplitOpenAddressingHashTable*>;
+
+		table_ptr _table;
+		size_type _index;
+
+		void skip_to_valid();
+
+	public:
+		HashIterator();
+		HashIterator(table_ptr table, size_type index);
+
+		reference operator*() const;
+		pointer operator->() const;
+
+		HashIterator& operator++();
+		HashIterator operator++(int);
+
+		bool operator==(const HashIterator& rhs) const;
+		bool operator!=(const HashIterator& rhs) const;
+	};
+
+	using iterator = HashIterator<false>;
+	using const_iterator = HashIterator<true>;
+
+
+	SplitOpenAddressingHashTable(size_type capacity = 16);
+	SplitOpenAddressingHashTable(std::initializer_list<value_type> init);
+	SplitOpenAddressingHashTable(size_type capacity, const hasher& hash, const key_equal& equal, const ProbingStrategy& strategy);
+	SplitOpenAddressingHashTable(const SplitOpenAddressingHashTable& other);
+	SplitOpenAddressingHashTable(SplitOpenAddressingHashTable&& other) noexcept;
+	~SplitOpenAddressingHashTable();
+
+	SplitOpenAddressingHashTable& operator=(const SplitOpenAddressingHashTable& other);
+	SplitOpenAddressingHashTable& operator=(SplitOpenAddressingHashTable&& other) noexcept;
+
+	std::pair<iterator, bool> insert(const value_type& kv);
+	std::pair<iterator, bool> insert(value_type&& kv);
+	std::pair<iterator, bool> insert(const key_type& key, const mapped_type& value);
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args);
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj);
+
+	// Under linear probing erase() backward-shifts later elements of the cluster into
+	// the freed slot, so it invalidates iterators, references and pointers to other
+	// elements. Other strategies leave a tombstone and invalidate only the erased one.
+	size_type erase(const key_type& key);
+
+	void clear();
+
+	mapped_type& operator[](const key_type& key);
+
+	mapped_type& at(const key_type& key);
+	const mapped_type& at(const key_type& key) const;
+
+	iterator find(const key_type& key);
+	const_iterator find(const key_type& key) const;
+
+	bool contains(const key_type& key) const;
+	size_type count(const key_type& key) const;
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+
+	size_type capacity() const noexcept;
+
+	float load_factor() const noexcept;
+	float max_load_factor() const noexcept;
+	void max_load_factor(float ml);
+	void reserve(size_type n);
+	void rehash(size_type new_capacity);
+
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
+
+	void swap(SplitOpenAddressingHashTable& other) noexcept;
+
+	bool operator==(const SplitOpenAddressingHashTable& other) const;
+	bool operator!=(const SplitOpenAddressingHashTable& other) const;
+
+private:
+	size_type find_index(const key_type& key) const;
+	std::pair<size_type, bool> probe_insert_slot(const key_type& key, size_type hash_value);
+	void check_load_and_rehash();
+	// Rehashes into new_capacity slots, or returns false with the table unchanged
+	// when the probe sequence of some key reaches no free slot.
+	bool rehash_into(size_type new_capacity);
+	void backward_shift(size_type hole);
+	mapped_type* value_ptr(size_type index) noexcept;
+	const mapped_type* value_ptr(size_type index) const noexcept;
+	template<typename KeyArg, typename... Args>
+	void construct_at(size_type index, KeyArg&& key, Args&&... args);
+	void allocate_storage(size_type n);
+	void destroy_storage() noexcept;
+	void copy_from(const SplitOpenAddressingHashTable& other);
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::skip_to_valid()
+{
+	while (_index < _table->_capacity && !_table->_keys[_index].is_occupied())
+		++_index;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::HashIterator()
+	: _table(nullptr)
+	, _index(0)
+{
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::HashIterator(table_ptr table, size_type index)
+	: _table(table)
+	, _index(index)
+{
+	skip_to_valid();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>::reference
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator*() const
+{
+	return reference(_table->_keys[_index].key(), *_table->value_ptr(_index));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>::pointer
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator->() const
+{
+	return pointer{ **this };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>&
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator++()
+{
+	++_index;
+	skip_to_valid();
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator++(int)
+{
+	HashIterator temp = *this;
+	++(*this);
+	return temp;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::operator==(const HashIterator& rhs) const
+{
+	return _table == rhs._table && _index == rhs._index;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::operator!=(const HashIterator& rhs) const
+{
+	return !(*this == rhs);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find_index(const key_type& key) const
+{
+	if (_capacity == 0)
+		return _capacity;
+
+	const size_type hash = _hash(key);
+	size_type index = _probing->probe(key, hash, 0, _capacity);
+	for (size_type i = 0; i < _capacity; index = _probing->next(key, hash, ++i, index, _capacity))
+	{
+		const key_bucket_type& bucket = _keys[index];
+
+		if (bucket.is_empty())
+			return _capacity;
+		if (bucket.is_occupied() && _equal(bucket.key(), key))
+			return index;
+	}
+	return _capacity;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline std::pair<typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type, bool>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::probe_insert_slot(const key_type& key, size_type hash_value)
+{
+	size_type first_deleted_index = _capacity;
+	if (_capacity == 0)
+		return { _capacity, false };
+
+	size_type index = _probing->probe(key, hash_value, 0, _capacity);
+	for (size_type i = 0; i < _capacity; index = _probing->next(key, hash_value, ++i, index, _capacity))
+	{
+		const key_bucket_type& bucket = _keys[index];
+
+		if (bucket.is_empty())
+			return { (first_deleted_index != _capacity ? first_deleted_index : index), true };
+		else if (bucket.is_deleted())
+		{
+			if (first_deleted_index == _capacity)
+				first_deleted_index = index;
+		}
+		else if (_equal(bucket.key(), key))
+			return { index, false };
+	}
+
+	if (first_deleted_index != _capacity)
+		return { first_deleted_index, true };
+
+	return { _capacity, false };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::check_load_and_rehash()
+{
+	if (load_factor() > max_load_factor())
+		rehash(_capacity * 2);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type*
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::value_ptr(size_type index) noexcept
+{
+	return std::launder(reinterpret_cast<mapped_type*>(&_values[index]));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline const typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type*
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::value_ptr(size_type index) const noexcept
+{
+	return std::launder(reinterpret_cast<const mapped_type*>(&_values[index]));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename KeyArg, typename... Args>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::construct_at(size_type index, KeyArg&& key, Args&&... args)
+{
+	new (&_values[index]) mapped_type(std::forward<Args>(args)...);
+	try
+	{
+		_keys[index].make_occupied(std::forward<KeyArg>(key));
+	}
+	catch (...)
+	{
+		value_ptr(index)->~mapped_type();
+		throw;
+	}
+	++_size;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::allocate_storage(size_type n)
+{
+	if (_probing)
+		n = _probing->adjust_capacity(n);
+
+	_keys.reset(new key_bucket_type[n]);
+	_values.reset(new value_storage[n]);
+	_capacity = n;
+	if (_probing)
+		_probing->set_capacity(n);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::destroy_storage() noexcept
+{
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_keys[i].is_occupied())
+			value_ptr(i)->~mapped_type();
+	}
+	_keys.reset();
+	_values.reset();
+	_capacity = 0;
+	_size = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::copy_from(const SplitOpenAddressingHashTable& other)
+{
+	allocate_storage(other._capacity);
+	for (size_type i = 0; i < other._capacity; ++i)
+	{
+		if (other._keys[i].is_occupied())
+			construct_at(i, other._keys[i].key(), *other.value_ptr(i));
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::SplitOpenAddressingHashTable(size_type capacity)
+	: _hash(Hash())
+	, _equal(KeyEqual())
+	, _probing(new ProbingStrategy())
+{
+	allocate_storage(capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::SplitOpenAddressingHashTable(std::initializer_list<value_type> init)
+	: SplitOpenAddressingHashTable(init.size())
+{
+	for (const auto& elem : init)
+		insert(elem);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::SplitOpenAddressingHashTable(size_type capacity, const hasher& hash, const key_equal& equal, const ProbingStrategy& strategy)
+	: _hash(hash)
+	, _equal(equal)
+	, _probing(strategy.clone())
+{
+	allocate_storage(capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::SplitOpenAddressingHashTable(const SplitOpenAddressingHashTable& other)
+	: _max_load_factor(other._max_load_factor)
+	, _hash(other._hash)
+	, _equal(other._equal)
+	, _probing(other._probing ? other._probing->clone() : nullptr)
+{
+	copy_from(other);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::SplitOpenAddressingHashTable(SplitOpenAddressingHashTable&& other) noexcept
+	: _keys(std::move(other._keys))
+	, _values(std::move(other._values))
+	, _capacity(other._capacity)
+	, _size(other._size)
+	, _max_load_factor(other._max_load_factor)
+	, _hash(std::move(other._hash))
+	, _equal(std::move(other._equal))
+	, _probing(other._probing)
+{
+	other._capacity = 0;
+	other._size = 0;
+	other._probing = nullptr;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::~SplitOpenAddressingHashTable()
+{
+	destroy_storage();
+	delete _probing;
+	_probing = nullptr;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>&
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::operator=(const SplitOpenAddressingHashTable& other)
+{
+	if (this != &other)
+	{
+		destroy_storage();
+		delete _probing;
+
+		_hash = other._hash;
+		_equal = other._equal;
+		_max_load_factor = other._max_load_factor;
+		_probing = other._probing ? other._probing->clone() : nullptr;
+		copy_from(other);
+	}
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>&
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::operator=(SplitOpenAddressingHashTable&& other) noexcept
+{
+	if (this != &other)
+	{
+		destroy_storage();
+		delete _probing;
+
+		_keys = std::move(other._keys);
+		_values = std::move(other._values);
+		_capacity = other._capacity;
+		_size = other._size;
+		_hash = std::move(other._hash);
+		_equal = std::move(other._equal);
+		_max_load_factor = other._max_load_factor;
+		_probing = other._probing;
+
+		other._capacity = 0;
+		other._size = 0;
+		other._probing = nullptr;
+	}
+	return *this;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(const value_type& kv)
+{
+	return try_emplace(kv.first, kv.second);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(value_type&& kv)
+{
+	return try_emplace(kv.first, std::move(kv.second));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::insert(const key_type& key, const mapped_type& value)
+{
+	return try_emplace(key, value);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename... Args>
+inline std::pair<typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::try_emplace(const key_type& key, Args&&... args)
+{
+	check_load_and_rehash();
+
+	auto [index, inserted] = probe_insert_slot(key, _hash(key));
+	if (index == _capacity)
+		return { end(), false };
+
+	if (inserted)
+		construct_at(index, key, std::forward<Args>(args)...);
+
+	return { iterator(this, index), inserted };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename M>
+inline std::pair<typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::insert_or_assign(const key_type& key, M&& obj)
+{
+	check_load_and_rehash();
+
+	auto [index, inserted] = probe_insert_slot(key, _hash(key));
+	if (index == _capacity)
+		return { end(), false };
+
+	if (inserted)
+		construct_at(index, key, std::forward<M>(obj));
+	else
+		*value_ptr(index) = std::forward<M>(obj);
+
+	return { iterator(this, index), inserted };
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	size_type index = find_index(key);
+	if (index == _capacity)
+		return 0;
+
+	value_ptr(index)->~mapped_type();
+	if constexpr (is_linear_probing<ProbingStrategy>::value)
+	{
+		_keys[index].make_empty();
+		backward_shift(index);
+	}
+	else
+		_keys[index].make_deleted();
+	--_size;
+	return 1;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::backward_shift(size_type hole)
+{
+	// Knuth's Algorithm R, as in OpenAddressingHashTable::backward_shift().
+	using home_strategy = typename unwrapped_probing<ProbingStrategy>::type;
+	size_type index = hole;
+	for (size_type i = 1; i < _capacity; ++i)
+	{
+		index = index + 1 < _capacity ? index + 1 : 0;
+		key_bucket_type& bucket = _keys[index];
+		if (bucket.is_empty())
+			return;
+		if (bucket.is_deleted())
+		{
+			_keys[hole].make_deleted();
+			return;
+		}
+
+		const size_type home = static_cast<const ProbingStrategy*>(_probing)->home_strategy::probe(bucket.key(), _hash(bucket.key()), 0, _capacity);
+		const bool stays = hole <= index ? (hole < home && home <= index) : (hole < home || home <= index);
+		if (stays)
+			continue;
+
+		try
+		{
+			new (&_values[hole]) mapped_type(std::move(*value_ptr(index)));
+		}
+		catch (...)
+		{
+			_keys[hole].make_deleted();
+			return;
+		}
+		try
+		{
+			_keys[hole].make_occupied(std::move(bucket.key()));
+		}
+		catch (...)
+		{
+			value_ptr(hole)->~mapped_type();
+			_keys[hole].make_deleted();
+			return;
+		}
+		value_ptr(index)->~mapped_type();
+		bucket.make_empty();
+		hole = index;
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_keys[i].is_occupied())
+			value_ptr(i)->~mapped_type();
+		_keys[i].make_empty();
+	}
+	_size = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::operator[](const key_type& key)
+{
+	check_load_and_rehash();
+
+	auto [index, inserted] = probe_insert_slot(key, _hash(key));
+	if (index == _capacity)
+	{
+		rehash(_capacity == 0 ? 16 : _capacity * 2);
+		return (*this)[key];
+	}
+
+	if (inserted)
+		construct_at(index, key);
+	return *value_ptr(index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key)
+{
+	size_type index = find_index(key);
+	if (index == _capacity)
+		throw std::out_of_range("Key not found");
+	return *value_ptr(index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+const typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key) const
+{
+	size_type index = find_index(key);
+	if (index == _capacity)
+		throw std::out_of_range("Key not found");
+	return *value_ptr(index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key)
+{
+	size_type index = find_index(key);
+	return index == _capacity ? end() : iterator(this, index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key) const
+{
+	size_type index = find_index(key);
+	return index == _capacity ? cend() : const_iterator(this, index);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key) const
+{
+	return find_index(key) != _capacity;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::count(const key_type& key) const
+{
+	return contains(key) ? 1 : 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size() const noexcept
+{
+	return _size;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::empty() const noexcept
+{
+	return _size == 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::capacity() const noexcept
+{
+	return _capacity;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+float SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::load_factor() const noexcept
+{
+	return _capacity == 0 ? 0.0f : static_cast<float>(_size) / static_cast<float>(_capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+float SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::max_load_factor() const noexcept
+{
+	return _max_load_factor;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::max_load_factor(float ml)
+{
+	if (ml <= 0.0f || ml > 1.0f)
+		throw std::invalid_argument("max_load_factor must be in (0, 1]");
+	_max_load_factor = ml;
+	check_load_and_rehash();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::reserve(size_type n)
+{
+	if (n > _capacity)
+		rehash(n);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::rehash(size_type new_capacity)
+{
+	// A key can miss a free slot only when its probe sequence does not cover the
+	// table; a larger table gives it more free slots to land on.
+	while (!rehash_into(new_capacity))
+		new_capacity = new_capacity == 0 ? 16 : new_capacity * 2;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::rehash_into(size_type new_capacity)
+{
+	constexpr bool move = relocate_by_move_v<Key, T>;
+	// Moving back is only safe when it cannot throw; copied elements never left.
+	constexpr bool move_back = std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<T>;
+
+	// New slot of each relocated element, in old slot order, so a failed rehash
+	// can move them back.
+	std::vector<size_type> placed;
+	placed.reserve(_size);
+
+	std::unique_ptr<key_bucket_type[]> old_keys = std::move(_keys);
+	std::unique_ptr<value_storage[]> old_values = std::move(_values);
+	const size_type old_capacity = _capacity;
+	const size_type old_size = _size;
+	auto old_value = [&old_values](size_type i) {
+		return std::launder(reinterpret_cast<mapped_type*>(&old_values[i]));
+	};
+
+	auto restore = [&]() noexcept {
+		size_type next = 0;
+		for (size_type i = 0; i < old_capacity && next < placed.size(); ++i)
+		{
+			if (!old_keys[i].is_occupied())
+				continue;
+			const size_type index = placed[next++];
+			if constexpr (move_back)
+			{
+				old_value(i)->~mapped_type();
+				new (&old_values[i]) mapped_type(std::move(*value_ptr(index)));
+				old_keys[i].make_occupied(std::move(_keys[index].key()));
+			}
+			value_ptr(index)->~mapped_type();
+		}
+		_keys = std::move(old_keys);
+		_values = std::move(old_values);
+		_capacity = old_capacity;
+		_size = old_size;
+		if (_probing)
+			_probing->set_capacity(old_capacity);
+	};
+
+	try
+	{
+		allocate_storage(new_capacity);
+		_size = 0;
+
+		for (size_type i = 0; i < old_capacity; ++i)
+		{
+			if (!old_keys[i].is_occupied())
+				continue;
+
+			key_type& key = old_keys[i].key();
+			auto [index, inserted] = probe_insert_slot(key, _hash(key));
+			if (!inserted)
+			{
+				restore();
+				return false;
+			}
+			construct_at(index, relocation_source<move>(key), relocation_source<move>(*old_value(i)));
+			placed.push_back(index);
+		}
+	}
+	catch (...)
+	{
+		restore();
+		throw;
+	}
+
+	for (size_type i = 0; i < old_capacity; ++i)
+	{
+		if (old_keys[i].is_occupied())
+			old_value(i)->~mapped_type();
+	}
+	return true;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+MemoryUsage SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Sizer>
+MemoryUsage SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage;
+	usage.object_bytes = sizeof(*this);
+	usage.slot_bytes = _capacity * (sizeof(key_type) + sizeof(mapped_type));
+	usage.metadata_bytes = _capacity * (sizeof(key_bucket_type) + sizeof(value_storage)) - usage.slot_bytes;
+	usage.probing_bytes = _probing ? sizeof(ProbingStrategy) : 0;
+
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_keys[i].is_occupied())
+			usage.external_bytes += sizer(_keys[i].key(), *value_ptr(i));
+	}
+	usage.payload_bytes = _size * (sizeof(key_type) + sizeof(mapped_type)) + usage.external_bytes;
+	return usage;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::begin()
+{
+	return iterator(this, 0);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::end()
+{
+	return iterator(this, _capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::begin() const
+{
+	return const_iterator(this, 0);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::end() const
+{
+	return const_iterator(this, _capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::cbegin() const
+{
+	return const_iterator(this, 0);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::cend() const
+{
+	return const_iterator(this, _capacity);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::swap(SplitOpenAddressingHashTable& other) noexcept
+{
+	std::swap(_keys, other._keys);
+	std::swap(_values, other._values);
+	std::swap(_capacity, other._capacity);
+	std::swap(_size, other._size);
+	std::swap(_max_load_factor, other._max_load_factor);
+	std::swap(_hash, other._hash);
+	std::swap(_equal, other._equal);
+	std::swap(_probing, other._probing);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::operator==(const SplitOpenAddressingHashTable& other) const
+{
+	if (_size != other._size)
+		return false;
+
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (!_keys[i].is_occupied())
+			continue;
+
+		size_type index = other.find_index(_keys[i].key());
+		if (index == other._capacity || !(*other.value_ptr(index) == *value_ptr(i)))
+			return false;
+	}
+	return true;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::operator!=(const SplitOpenAddressingHashTable& other) const
+{
+	return !(*this == other);
+}
+
+template<typename K, typename M, typename H, typename E, typename P>
+inline void swap(SplitOpenAddressingHashTable<K, M, H, E, P>& lhs, SplitOpenAddressingHashTable<K, M, H, E, P>& rhs) noexcept
+{
+	lhs.swap(rhs);
+}
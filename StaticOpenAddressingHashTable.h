@@ -0,0 +1,616 @@
+#pragma once
+
+#include <tuple>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <functional>
+
+#include "Bucket.h"
+#include "MemoryUsage.h"
+#include "ProbingStrategy.h"
+#include "LinearProbing.h"
+
+// Fixed-capacity table with its buckets in an inline array. The probing strategy
+// is held by value, nothing is ever allocated and the table never rehashes: when
+// no slot is left, insert() returns { end(), false }.
+template<
+	typename Key,
+	typename T,
+	std::size_t N,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class StaticOpenAddressingHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using value_type = std::pair<const Key, T>;
+	using bucket_type = Bucket<Key, T>;
+	using probing_strategy_type = ProbingStrategy;
+
+	static_assert(N > 0, "StaticOpenAddressingHashTable needs a non-zero capacity");
+
+private:
+	bucket_type _buckets[N];
+	size_type _size = 0;
+
+	hasher _hash;
+	key_equal _equal;
+	ProbingStrategy _probing;
+
+public:
+	template<bool IsConst>
+	class HashIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::pair<const Key, T>;
+		using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+		using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+
+	private:
+		using bucket_ptr = std::conditional_t<IsConst, const bucket_type*, bucket_type*>;
+
+		bucket_ptr _current;
+		bucket_ptr _end;
+
+		void skip_to_valid();
+
+	public:
+		HashIterator();
+		HashIterator(bucket_ptr current, bucket_ptr end);
+
+		reference operator*() const;
+		pointer operator->() const;
+
+		HashIterator& operator++();
+		HashIterator operator++(int);
+
+		bool operator==(const HashIterator& rhs) const;
+		bool operator!=(const HashIterator& rhs) const;
+	};
+
+	using iterator = HashIterator<false>;
+	using const_iterator = HashIterator<true>;
+
+
+	StaticOpenAddressingHashTable();
+	StaticOpenAddressingHashTable(std::initializer_list<value_type> init);
+	StaticOpenAddressingHashTable(const hasher& hash, const key_equal& equal, const ProbingStrategy& strategy);
+	StaticOpenAddressingHashTable(const StaticOpenAddressingHashTable& other);
+
+	StaticOpenAddressingHashTable& operator=(const StaticOpenAddressingHashTable& other);
+
+	std::pair<iterator, bool> insert(const value_type& kv);
+	std::pair<iterator, bool> insert(value_type&& kv);
+	std::pair<iterator, bool> insert(const key_type& key, const mapped_type& value);
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args);
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj);
+
+	// Under linear probing erase() backward-shifts later elements of the cluster into
+	// the freed slot, so it invalidates iterators, references and pointers to other
+	// elements. Other strategies leave a tombstone and invalidate only the erased one.
+	size_type erase(const key_type& key);
+
+	void clear();
+
+	mapped_type& at(const key_type& key);
+	const mapped_type& at(const key_type& key) const;
+
+	iterator find(const key_type& key);
+	const_iterator find(const key_type& key) const;
+
+	bool contains(const key_type& key) const;
+	size_type count(const key_type& key) const;
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+	bool full() const noexcept;
+
+	static constexpr size_type capacity() noexcept { return N; }
+
+	float load_factor() const noexcept;
+
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
+
+private:
+	size_type find_index(const key_type& key) const;
+	std::pair<size_type, bool> probe_insert_slot(const key_type& key, size_type hash_value);
+	void init_probing();
+	// Refills the just-emptied slot hole from the rest of its cluster (linear probing only).
+	void backward_shift(size_type hole);
+	void copy_from(const StaticOpenAddressingHashTable& other);
+};
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline void StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::skip_to_valid()
+{
+	while (_current != _end && !_current->is_occupied())
+		++_current;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::HashIterator()
+	: _current(nullptr)
+	, _end(nullptr)
+{
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::HashIterator(bucket_ptr current, bucket_ptr end)
+	: _current(current)
+	, _end(end)
+{
+	skip_to_valid();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>::reference
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator*() const
+{
+	return _current->value_ref();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>::pointer
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator->() const
+{
+	return &_current->value_ref();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>&
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator++()
+{
+	++_current;
+	skip_to_valid();
+	return *this;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::template HashIterator<IsConst>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>::operator++(int)
+{
+	HashIterator temp = *this;
+	++(*this);
+	return temp;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline bool StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::operator==(const HashIterator& rhs) const
+{
+	return _current == rhs._current;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<bool IsConst>
+inline bool StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::HashIterator<IsConst>
+		::operator!=(const HashIterator& rhs) const
+{
+	return _current != rhs._current;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::size_type
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::find_index(const key_type& key) const
+{
+	const size_type hash = _hash(key);
+	size_type index = _probing.probe(key, hash, 0, N);
+	for (size_type i = 0; i < N; index = _probing.next(key, hash, ++i, index, N))
+	{
+		const bucket_type& bucket = _buckets[index];
+
+		if (bucket.is_empty())
+			return N;
+		if (bucket.is_occupied() && _equal(bucket.key(), key))
+			return index;
+	}
+	return N;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline std::pair<typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::size_type, bool>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::probe_insert_slot(const key_type& key, size_type hash_value)
+{
+	size_type first_deleted_index = N;
+
+	size_type index = _probing.probe(key, hash_value, 0, N);
+	for (size_type i = 0; i < N; index = _probing.next(key, hash_value, ++i, index, N))
+	{
+		const bucket_type& bucket = _buckets[index];
+
+		if (bucket.is_empty())
+			return { (first_deleted_index != N ? first_deleted_index : index), true };
+		else if (bucket.is_deleted())
+		{
+			if (first_deleted_index == N)
+				first_deleted_index = index;
+		}
+		else if (_equal(bucket.key(), key))
+			return { index, false };
+	}
+
+	if (first_deleted_index != N)
+		return { first_deleted_index, true };
+
+	return { N, false };
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::init_probing()
+{
+	if (_probing.adjust_capacity(N) != N)
+		throw std::invalid_argument("capacity is not supported by the probing strategy");
+	_probing.set_capacity(N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline void StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::copy_from(const StaticOpenAddressingHashTable& other)
+{
+	for (size_type i = 0; i < N; ++i)
+	{
+		if (other._buckets[i].is_occupied())
+			_buckets[i].make_occupied(other._buckets[i].key(), other._buckets[i].get_mapped());
+		else if (other._buckets[i].is_deleted())
+			_buckets[i].make_deleted();
+		else
+			_buckets[i].make_empty();
+	}
+	_size = other._size;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::StaticOpenAddressingHashTable()
+	: _hash(Hash())
+	, _equal(KeyEqual())
+	, _probing()
+{
+	init_probing();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::StaticOpenAddressingHashTable(std::initializer_list<value_type> init)
+	: StaticOpenAddressingHashTable()
+{
+	for (const auto& elem : init)
+		insert(elem);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::StaticOpenAddressingHashTable(const hasher& hash, const key_equal& equal, const ProbingStrategy& strategy)
+	: _hash(hash)
+	, _equal(equal)
+	, _probing(strategy)
+{
+	init_probing();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::StaticOpenAddressingHashTable(const StaticOpenAddressingHashTable& other)
+	: _hash(other._hash)
+	, _equal(other._equal)
+	, _probing(other._probing)
+{
+	copy_from(other);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>&
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::operator=(const StaticOpenAddressingHashTable& other)
+{
+	if (this != &other)
+	{
+		_hash = other._hash;
+		_equal = other._equal;
+		_probing = other._probing;
+		copy_from(other);
+	}
+	return *this;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::insert(const value_type& kv)
+{
+	return try_emplace(kv.first, kv.second);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::insert(value_type&& kv)
+{
+	return try_emplace(kv.first, std::move(kv.second));
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::pair<typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::insert(const key_type& key, const mapped_type& value)
+{
+	return try_emplace(key, value);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename... Args>
+inline std::pair<typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::try_emplace(const key_type& key, Args&&... args)
+{
+	auto [index, inserted] = probe_insert_slot(key, _hash(key));
+	if (index == N)
+		return { end(), false };
+
+	if (inserted)
+	{
+		_buckets[index].make_occupied(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		++_size;
+	}
+	return { iterator(_buckets + index, _buckets + N), inserted };
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename M>
+inline std::pair<typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator, bool>
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>
+		::insert_or_assign(const key_type& key, M&& obj)
+{
+	auto [index, inserted] = probe_insert_slot(key, _hash(key));
+	if (index == N)
+		return { end(), false };
+
+	if (inserted)
+	{
+		_buckets[index].make_occupied(key, std::forward<M>(obj));
+		++_size;
+	}
+	else
+		_buckets[index].get_mapped() = std::forward<M>(obj);
+
+	return { iterator(_buckets + index, _buckets + N), inserted };
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::size_type
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	size_type index = find_index(key);
+	if (index == N)
+		return 0;
+
+	// The table never rehashes, so tombstones would never be purged; linear probing
+	// avoids them entirely.
+	if constexpr (is_linear_probing<ProbingStrategy>::value)
+	{
+		_buckets[index].make_empty();
+		backward_shift(index);
+	}
+	else
+		_buckets[index].make_deleted();
+	--_size;
+	return 1;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::backward_shift(size_type hole)
+{
+	// Knuth's Algorithm R, as in OpenAddressingHashTable::backward_shift().
+	using home_strategy = typename unwrapped_probing<ProbingStrategy>::type;
+	size_type index = hole;
+	for (size_type i = 1; i < N; ++i)
+	{
+		index = index + 1 < N ? index + 1 : 0;
+		bucket_type& bucket = _buckets[index];
+		if (bucket.is_empty())
+			return;
+		if (bucket.is_deleted())
+		{
+			_buckets[hole].make_deleted();
+			return;
+		}
+
+		const key_type& key = bucket.key();
+		const size_type home = _probing.home_strategy::probe(key, _hash(key), 0, N);
+		const bool stays = hole <= index ? (hole < home && home <= index) : (hole < home || home <= index);
+		if (stays)
+			continue;
+
+		try
+		{
+			_buckets[hole].make_occupied(std::move(bucket.value()));
+		}
+		catch (...)
+		{
+			_buckets[hole].make_deleted();
+			return;
+		}
+		bucket.make_empty();
+		hole = index;
+	}
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	for (auto& bucket : _buckets)
+		bucket.clear();
+	_size = 0;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key)
+{
+	size_type index = find_index(key);
+	if (index == N)
+		throw std::out_of_range("Key not found");
+	return _buckets[index].get_mapped();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+const typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::mapped_type&
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::at(const key_type& key) const
+{
+	size_type index = find_index(key);
+	if (index == N)
+		throw std::out_of_range("Key not found");
+	return _buckets[index].get_mapped();
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key)
+{
+	size_type index = find_index(key);
+	return index == N ? end() : iterator(_buckets + index, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key) const
+{
+	size_type index = find_index(key);
+	return index == N ? cend() : const_iterator(_buckets + index, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key) const
+{
+	return find_index(key) != N;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::size_type
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::count(const key_type& key) const
+{
+	return contains(key) ? 1 : 0;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::size_type
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::size() const noexcept
+{
+	return _size;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::empty() const noexcept
+{
+	return _size == 0;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::full() const noexcept
+{
+	return _size == N;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+float StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::load_factor() const noexcept
+{
+	return static_cast<float>(_size) / static_cast<float>(N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+MemoryUsage StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::memory_usage() const
+{
+	return memory_usage([](const key_type&, const mapped_type&) { return size_type(0); });
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Sizer>
+MemoryUsage StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::memory_usage(Sizer sizer) const
+{
+	// Buckets and strategy are inline, so the breakdown adds up to sizeof(*this).
+	MemoryUsage usage;
+	usage.slot_bytes = N * sizeof(value_type);
+	usage.metadata_bytes = N * (sizeof(bucket_type) - sizeof(value_type));
+	usage.probing_bytes = sizeof(ProbingStrategy);
+	usage.object_bytes = sizeof(*this) - N * sizeof(bucket_type) - sizeof(ProbingStrategy);
+
+	for (size_type i = 0; i < N; ++i)
+	{
+		if (_buckets[i].is_occupied())
+			usage.external_bytes += sizer(_buckets[i].key(), _buckets[i].get_mapped());
+	}
+	usage.payload_bytes = _size * sizeof(value_type) + usage.external_bytes;
+	return usage;
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::begin()
+{
+	return iterator(_buckets, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::end()
+{
+	return iterator(_buckets + N, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::begin() const
+{
+	return const_iterator(_buckets, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::end() const
+{
+	return const_iterator(_buckets + N, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::cbegin() const
+{
+	return const_iterator(_buckets, _buckets + N);
+}
+
+template<typename Key, typename T, std::size_t N, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::const_iterator
+		StaticOpenAddressingHashTable<Key, T, N, Hash, KeyEqual, ProbingStrategy>::cend() const
+{
+	return const_iterator(_buckets + N, _buckets + N);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <string_view>
+
+// Append-only byte arena for string data. Stored strings are never moved, so the
+// returned views stay valid until clear() or destruction, across moves of the arena.
+class StringArena
+{
+private:
+	std::vector<std::unique_ptr<char[]>> _chunks;
+	char* _cursor = nullptr;
+	std::size_t _remaining = 0;
+	std::size_t _chunk_size;
+	std::size_t _bytes_used = 0;
+	std::size_t _bytes_reserved = 0;
+
+public:
+	explicit StringArena(std::size_t chunk_size = 64 * 1024)
+		: _chunk_size(chunk_size == 0 ? 1 : chunk_size)
+	{
+	}
+
+	StringArena(const StringArena&) = delete;
+	StringArena& operator=(const StringArena&) = delete;
+
+	StringArena(StringArena&& other) noexcept
+		: _chunks(std::move(other._chunks))
+		, _cursor(other._cursor)
+		, _remaining(other._remaining)
+		, _chunk_size(other._chunk_size)
+		, _bytes_used(other._bytes_used)
+		, _bytes_reserved(other._bytes_reserved)
+	{
+		other.reset_counters();
+	}
+
+	StringArena& operator=(StringArena&& other) noexcept
+	{
+		if (this != &other)
+		{
+			_chunks = std::move(other._chunks);
+			_cursor = other._cursor;
+			_remaining = other._remaining;
+			_chunk_size = other._chunk_size;
+			_bytes_used = other._bytes_used;
+			_bytes_reserved = other._bytes_reserved;
+			other.reset_counters();
+		}
+		return *this;
+	}
+
+	std::string_view store(std::string_view s)
+	{
+		if (s.empty())
+			return std::string_view();
+
+		char* data;
+		if (s.size() > _chunk_size / 4)
+		{
+			// Large strings get a chunk of their own instead of wasting the tail of
+			// the current one.
+			_chunks.emplace_back(new char[s.size()]);
+			data = _chunks.back().get();
+			_bytes_reserved += s.size();
+		}
+		else
+		{
+			if (s.size() > _remaining)
+			{
+				_chunks.emplace_back(new char[_chunk_size]);
+				_cursor = _chunks.back().get();
+				_remaining = _chunk_size;
+				_bytes_reserved += _chunk_size;
+			}
+			data = _cursor;
+			_cursor += s.size();
+			_remaining -= s.size();
+		}
+
+		std::memcpy(data, s.data(), s.size());
+		_bytes_used += s.size();
+		return std::string_view(data, s.size());
+	}
+
+	void clear() noexcept
+	{
+		_chunks.clear();
+		reset_counters();
+	}
+
+	[[nodiscard]] std::size_t bytes_used() const noexcept { return _bytes_used; }
+	[[nodiscard]] std::size_t bytes_reserved() const noexcept { return _bytes_reserved; }
+
+private:
+	void reset_counters() noexcept
+	{
+		_cursor = nullptr;
+		_remaining = 0;
+		_bytes_used = 0;
+		_bytes_reserved = 0;
+	}
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+#include "StringArena.h"
+#include "OpenAddressingHashTable.h"
+
+// Dictionary encoder that interns strings and hands out dense 32-bit ids in
+// first-seen order. Bytes are copied once into an append-only arena; the table
+// keys and the id-to-string vector are both views into it, so decode() is a
+// single vector index.
+template<
+	typename Hash = std::hash<std::string_view>,
+	typename ProbingStrategy = LinearProbing<std::string_view>
+>
+class StringDictionary
+{
+public:
+	using id_type = std::uint32_t;
+	using size_type = std::size_t;
+	using table_type = OpenAddressingHashTable<std::string_view, id_type, Hash, std::equal_to<std::string_view>, ProbingStrategy>;
+
+private:
+	StringArena _arena;
+	table_type _ids;
+	std::vector<std::string_view> _strings;
+
+public:
+	explicit StringDictionary(size_type capacity = 16)
+		: _ids(capacity)
+	{
+	}
+
+	StringDictionary(const StringDictionary&) = delete;
+	StringDictionary& operator=(const StringDictionary&) = delete;
+	StringDictionary(StringDictionary&&) noexcept = default;
+	StringDictionary& operator=(StringDictionary&&) noexcept = default;
+
+	// Id of s, interning it first if it has not been seen.
+	id_type encode(std::string_view s)
+	{
+		auto it = _ids.find(s);
+		if (it != _ids.end())
+			return it->second;
+
+		if (_strings.size() > std::numeric_limits<id_type>::max())
+			throw std::length_error("StringDictionary id space exhausted");
+
+		const id_type id = static_cast<id_type>(_strings.size());
+		const std::string_view stored = _arena.store(s);
+		// The id is withdrawn unless it gets indexed; otherwise a later encode of s
+		// would mint a duplicate.
+		_strings.push_back(stored);
+		try
+		{
+			// A failed insert means the probe path had no free slot; growing
+			// lowers the load so the retry finds one.
+			if (_ids.insert(stored, id).first == _ids.end())
+			{
+				_ids.rehash(_ids.capacity() * 2);
+				if (_ids.insert(stored, id).first == _ids.end())
+					throw std::runtime_error("StringDictionary could not index a new string");
+			}
+		}
+		catch (...)
+		{
+			_strings.pop_back();
+			throw;
+		}
+		return id;
+	}
+
+	// Batch form for column ingestion; out must have room for count ids. std::span
+	// is C++20, so the batch takes a pointer and count.
+	void encode(const std::string_view* values, size_type count, id_type* out)
+	{
+		for (size_type i = 0; i < count; ++i)
+			out[i] = encode(values[i]);
+	}
+
+	std::vector<id_type> encode(const std::vector<std::string_view>& values)
+	{
+		std::vector<id_type> ids(values.size());
+		encode(values.data(), values.size(), ids.data());
+		return ids;
+	}
+
+	// Id of s without interning it.
+	std::optional<id_type> find(std::string_view s) const
+	{
+		auto it = _ids.find(s);
+		if (it == _ids.end())
+			return std::nullopt;
+		return it->second;
+	}
+
+	bool contains(std::string_view s) const
+	{
+		return _ids.contains(s);
+	}
+
+	std::string_view decode(id_type id) const
+	{
+		return _strings[id];
+	}
+
+	std::string_view at(id_type id) const
+	{
+		if (id >= _strings.size())
+			throw std::out_of_range("Id not found");
+		return _strings[id];
+	}
+
+	void reserve(size_type n)
+	{
+		_ids.reserve(static_cast<size_type>(static_cast<float>(n) / _ids.max_load_factor()) + 1);
+		_strings.reserve(n);
+	}
+
+	void clear()
+	{
+		_ids.clear();
+		_strings.clear();
+		_arena.clear();
+	}
+
+	size_type size() const noexcept { return _strings.size(); }
+	bool empty() const noexcept { return _strings.empty(); }
+	size_type arena_bytes() const noexcept { return _arena.bytes_reserved(); }
+};
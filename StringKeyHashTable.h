@@ -0,0 +1,832 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <functional>
+#include <string_view>
+
+#include "Bucket.h"
+#include "MemoryUsage.h"
+#include "StringArena.h"
+#include "InlineStringKey.h"
+#include "ProbingStrategy.h"
+#include "LinearProbing.h"
+
+// String-keyed table whose slots store keys as InlineStringKey: short keys live in
+// the slot next to their hash, so a string_view lookup compares bytes in place
+// instead of chasing a std::string's heap pointer. Longer keys spill into an
+// append-only arena owned by the table. Erased spilled keys are reclaimed when a
+// rehash compacts the arena, which an insert triggers once dead bytes outnumber live ones.
+template<
+	typename T,
+	typename Hash = std::hash<std::string_view>,
+	typename ProbingStrategy = LinearProbing<std::string_view>
+>
+class StringKeyHashTable
+{
+public:
+	using key_type = std::string_view;
+	using mapped_type = T;
+	using hasher = Hash;
+	using size_type = std::size_t;
+	using probing_strategy_type = ProbingStrategy;
+	using base_probing_strategy_type = IProbingStrategy<std::string_view>;
+
+private:
+	struct slot_type
+	{
+		BucketState state = BucketState::EMPTY;
+		InlineStringKey key;
+		alignas(T) unsigned char value[sizeof(T)];
+	};
+
+	std::unique_ptr<slot_type[]> _slots;
+	size_type _capacity = 0;
+	size_type _size = 0;
+	float _max_load_factor = 0.75f;
+
+	hasher _hash;
+	base_probing_strategy_type* _probing = nullptr;
+	StringArena _arena;
+	// Arena bytes still referenced by occupied slots; the rest of bytes_used() is dead.
+	size_type _live_arena_bytes = 0;
+
+public:
+	template<bool IsConst>
+	class HashIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = std::pair<std::string_view, T>;
+		using reference = std::pair<std::string_view, std::conditional_t<IsConst, const T&, T&>>;
+
+		struct pointer
+		{
+			reference ref;
+			reference* operator->() { return &ref; }
+		};
+
+	private:
+		using table_ptr = std::conditional_t<IsConst, const StringKeyHashTable*, StringKeyHashTable*>;
+
+		table_ptr _table;
+		size_type _index;
+
+		void skip_to_valid();
+
+	public:
+		HashIterator();
+		HashIterator(table_ptr table, size_type index);
+
+		reference operator*() const;
+		pointer operator->() const;
+
+		HashIterator& operator++();
+		HashIterator operator++(int);
+
+		bool operator==(const HashIterator& rhs) const;
+		bool operator!=(const HashIterator& rhs) const;
+	};
+
+	using iterator = HashIterator<false>;
+	using const_iterator = HashIterator<true>;
+
+
+	StringKeyHashTable(size_type capacity = 16);
+	StringKeyHashTable(size_type capacity, const hasher& hash, const ProbingStrategy& strategy);
+	StringKeyHashTable(const StringKeyHashTable& other) = delete;
+	StringKeyHashTable(StringKeyHashTable&& other) noexcept;
+	~StringKeyHashTable();
+
+	StringKeyHashTable& operator=(const StringKeyHashTable& other) = delete;
+	StringKeyHashTable& operator=(StringKeyHashTable&& other) noexcept;
+
+	std::pair<iterator, bool> insert(std::string_view key, const mapped_type& value);
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args);
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(std::string_view key, M&& obj);
+
+	// Under linear probing erase() backward-shifts later elements of the cluster into
+	// the freed slot, so it invalidates iterators and references to other elements.
+	// Other strategies leave a tombstone and invalidate only the erased one.
+	size_type erase(std::string_view key);
+
+	void clear();
+
+	mapped_type& operator[](std::string_view key);
+
+	mapped_type& at(std::string_view key);
+	const mapped_type& at(std::string_view key) const;
+
+	iterator find(std::string_view key);
+	const_iterator find(std::string_view key) const;
+
+	bool contains(std::string_view key) const;
+	size_type count(std::string_view key) const;
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+
+	size_type capacity() const noexcept;
+	size_type arena_bytes() const noexcept;
+
+	float load_factor() const noexcept;
+	float max_load_factor() const noexcept;
+	void max_load_factor(float ml);
+	void reserve(size_type n);
+	void rehash(size_type new_capacity);
+
+	// Spilled key bytes count as external heap, with the whole arena reserve as
+	// overhead; sizer(key, mapped) adds what a value owns outside its slot.
+	MemoryUsage memory_usage() const;
+
+	template<typename Sizer>
+	MemoryUsage memory_usage(Sizer sizer) const;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
+
+private:
+	size_type find_index(std::string_view key, size_type hash) const;
+	std::pair<size_type, bool> probe_insert_slot(std::string_view key, size_type hash);
+	void check_load_and_rehash();
+	// Rehashes into new_capacity slots, or returns false with the table unchanged
+	// when the probe sequence of some key reaches no free slot.
+	bool rehash_into(size_type new_capacity);
+	bool arena_needs_compaction() const noexcept;
+	void backward_shift(size_type hole);
+	static mapped_type* value_ptr(slot_type& slot) noexcept;
+	static const mapped_type* value_ptr(const slot_type& slot) noexcept;
+	void allocate_slots(size_type n);
+	void destroy_slots() noexcept;
+};
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+inline void StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::skip_to_valid()
+{
+	while (_index < _table->_capacity && _table->_slots[_index].state != BucketState::OCCUPIED)
+		++_index;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::HashIterator()
+	: _table(nullptr)
+	, _index(0)
+{
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::HashIterator(table_ptr table, size_type index)
+	: _table(table)
+	, _index(index)
+{
+	skip_to_valid();
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::template HashIterator<IsConst>::reference
+		StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::operator*() const
+{
+	auto& slot = _table->_slots[_index];
+	return reference(slot.key.view(), *value_ptr(slot));
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::template HashIterator<IsConst>::pointer
+		StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::operator->() const
+{
+	return pointer{ **this };
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::template HashIterator<IsConst>&
+		StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::operator++()
+{
+	++_index;
+	skip_to_valid();
+	return *this;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::template HashIterator<IsConst>
+		StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::operator++(int)
+{
+	HashIterator temp = *this;
+	++(*this);
+	return temp;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+inline bool StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::operator==(const HashIterator& rhs) const
+{
+	return _table == rhs._table && _index == rhs._index;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<bool IsConst>
+inline bool StringKeyHashTable<T, Hash, ProbingStrategy>::HashIterator<IsConst>::operator!=(const HashIterator& rhs) const
+{
+	return !(*this == rhs);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type
+		StringKeyHashTable<T, Hash, ProbingStrategy>::find_index(std::string_view key, size_type hash) const
+{
+	if (_capacity == 0)
+		return _capacity;
+
+	size_type index = _probing->probe(key, hash, 0, _capacity);
+	for (size_type i = 0; i < _capacity; index = _probing->next(key, hash, ++i, index, _capacity))
+	{
+		const slot_type& slot = _slots[index];
+
+		if (slot.state == BucketState::EMPTY)
+			return _capacity;
+		if (slot.state == BucketState::OCCUPIED && slot.key.equals(key, hash))
+			return index;
+	}
+	return _capacity;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline std::pair<typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type, bool>
+		StringKeyHashTable<T, Hash, ProbingStrategy>::probe_insert_slot(std::string_view key, size_type hash)
+{
+	size_type first_deleted_index = _capacity;
+	if (_capacity == 0)
+		return { _capacity, false };
+
+	size_type index = _probing->probe(key, hash, 0, _capacity);
+	for (size_type i = 0; i < _capacity; index = _probing->next(key, hash, ++i, index, _capacity))
+	{
+		const slot_type& slot = _slots[index];
+
+		if (slot.state == BucketState::EMPTY)
+			return { (first_deleted_index != _capacity ? first_deleted_index : index), true };
+		else if (slot.state == BucketState::DELETED)
+		{
+			if (first_deleted_index == _capacity)
+				first_deleted_index = index;
+		}
+		else if (slot.key.equals(key, hash))
+			return { index, false };
+	}
+
+	if (first_deleted_index != _capacity)
+		return { first_deleted_index, true };
+
+	return { _capacity, false };
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline void StringKeyHashTable<T, Hash, ProbingStrategy>::check_load_and_rehash()
+{
+	if (load_factor() > max_load_factor())
+		rehash(_capacity * 2);
+	else if (arena_needs_compaction())
+		rehash(_capacity);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline bool StringKeyHashTable<T, Hash, ProbingStrategy>::arena_needs_compaction() const noexcept
+{
+	// The floor keeps small tables from rehashing over a handful of dead keys.
+	constexpr size_type min_dead_bytes = 64 * 1024;
+	const size_type dead = _arena.bytes_used() - _live_arena_bytes;
+	return dead > min_dead_bytes && dead > _live_arena_bytes;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline typename StringKeyHashTable<T, Hash, ProbingStrategy>::mapped_type*
+		StringKeyHashTable<T, Hash, ProbingStrategy>::value_ptr(slot_type& slot) noexcept
+{
+	return std::launder(reinterpret_cast<mapped_type*>(&slot.value));
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline const typename StringKeyHashTable<T, Hash, ProbingStrategy>::mapped_type*
+		StringKeyHashTable<T, Hash, ProbingStrategy>::value_ptr(const slot_type& slot) noexcept
+{
+	return std::launder(reinterpret_cast<const mapped_type*>(&slot.value));
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline void StringKeyHashTable<T, Hash, ProbingStrategy>::allocate_slots(size_type n)
+{
+	if (_probing)
+		n = _probing->adjust_capacity(n);
+
+	_slots.reset(new slot_type[n]);
+	_capacity = n;
+	if (_probing)
+		_probing->set_capacity(n);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline void StringKeyHashTable<T, Hash, ProbingStrategy>::destroy_slots() noexcept
+{
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_slots[i].state == BucketState::OCCUPIED)
+			value_ptr(_slots[i])->~mapped_type();
+	}
+	_slots.reset();
+	_capacity = 0;
+	_size = 0;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>::StringKeyHashTable(size_type capacity)
+	: _hash(Hash())
+	, _probing(new ProbingStrategy())
+{
+	allocate_slots(capacity);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>::StringKeyHashTable(size_type capacity, const hasher& hash, const ProbingStrategy& strategy)
+	: _hash(hash)
+	, _probing(strategy.clone())
+{
+	allocate_slots(capacity);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>::StringKeyHashTable(StringKeyHashTable&& other) noexcept
+	: _slots(std::move(other._slots))
+	, _capacity(other._capacity)
+	, _size(other._size)
+	, _max_load_factor(other._max_load_factor)
+	, _hash(std::move(other._hash))
+	, _probing(other._probing)
+	, _arena(std::move(other._arena))
+	, _live_arena_bytes(other._live_arena_bytes)
+{
+	other._live_arena_bytes = 0;
+	other._capacity = 0;
+	other._size = 0;
+	other._probing = nullptr;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>::~StringKeyHashTable()
+{
+	destroy_slots();
+	delete _probing;
+	_probing = nullptr;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+inline StringKeyHashTable<T, Hash, ProbingStrategy>&
+		StringKeyHashTable<T, Hash, ProbingStrategy>::operator=(StringKeyHashTable&& other) noexcept
+{
+	if (this != &other)
+	{
+		destroy_slots();
+		delete _probing;
+
+		_slots = std::move(other._slots);
+		_capacity = other._capacity;
+		_size = other._size;
+		_max_load_factor = other._max_load_factor;
+		_hash = std::move(other._hash);
+		_probing = other._probing;
+		_arena = std::move(other._arena);
+		_live_arena_bytes = other._live_arena_bytes;
+		other._live_arena_bytes = 0;
+
+		other._capacity = 0;
+		other._size = 0;
+		other._probing = nullptr;
+	}
+	return *this;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+std::pair<typename StringKeyHashTable<T, Hash, ProbingStrategy>::iterator, bool>
+		StringKeyHashTable<T, Hash, ProbingStrategy>::insert(std::string_view key, const mapped_type& value)
+{
+	return try_emplace(key, value);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<typename... Args>
+inline std::pair<typename StringKeyHashTable<T, Hash, ProbingStrategy>::iterator, bool>
+		StringKeyHashTable<T, Hash, ProbingStrategy>::try_emplace(std::string_view key, Args&&... args)
+{
+	check_load_and_rehash();
+
+	const size_type hash = _hash(key);
+	auto [index, inserted] = probe_insert_slot(key, hash);
+	if (index == _capacity)
+		return { end(), false };
+
+	if (inserted)
+	{
+		// The key goes first: if the arena throws, no value has been built yet.
+		const InlineStringKey stored(key, hash, _arena);
+		slot_type& slot = _slots[index];
+		new (&slot.value) mapped_type(std::forward<Args>(args)...);
+		slot.key = stored;
+		slot.state = BucketState::OCCUPIED;
+		if (!stored.is_inline())
+			_live_arena_bytes += key.size();
+		++_size;
+	}
+	return { iterator(this, index), inserted };
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<typename M>
+inline std::pair<typename StringKeyHashTable<T, Hash, ProbingStrategy>::iterator, bool>
+		StringKeyHashTable<T, Hash, ProbingStrategy>::insert_or_assign(std::string_view key, M&& obj)
+{
+	auto result = try_emplace(key, std::forward<M>(obj));
+	if (!result.second && result.first != end())
+		result.first->second = std::forward<M>(obj);
+	return result;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type
+		StringKeyHashTable<T, Hash, ProbingStrategy>::erase(std::string_view key)
+{
+	size_type index = find_index(key, _hash(key));
+	if (index == _capacity)
+		return 0;
+
+	value_ptr(_slots[index])->~mapped_type();
+	if (!_slots[index].key.is_inline())
+		_live_arena_bytes -= key.size();
+	if constexpr (is_linear_probing<ProbingStrategy>::value)
+	{
+		_slots[index].state = BucketState::EMPTY;
+		backward_shift(index);
+	}
+	else
+		_slots[index].state = BucketState::DELETED;
+	--_size;
+	return 1;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+void StringKeyHashTable<T, Hash, ProbingStrategy>::backward_shift(size_type hole)
+{
+	// Knuth's Algorithm R, as in OpenAddressingHashTable::backward_shift(). Slots
+	// carry their key's hash, so finding a home slot costs no rehash.
+	using home_strategy = typename unwrapped_probing<ProbingStrategy>::type;
+	size_type index = hole;
+	for (size_type i = 1; i < _capacity; ++i)
+	{
+		index = index + 1 < _capacity ? index + 1 : 0;
+		slot_type& slot = _slots[index];
+		if (slot.state == BucketState::EMPTY)
+			return;
+		if (slot.state == BucketState::DELETED)
+		{
+			_slots[hole].state = BucketState::DELETED;
+			return;
+		}
+
+		const size_type home = static_cast<const ProbingStrategy*>(_probing)->home_strategy::probe(slot.key.view(), slot.key.hash(), 0, _capacity);
+		const bool stays = hole <= index ? (hole < home && home <= index) : (hole < home || home <= index);
+		if (stays)
+			continue;
+
+		try
+		{
+			new (&_slots[hole].value) mapped_type(std::move(*value_ptr(slot)));
+		}
+		catch (...)
+		{
+			_slots[hole].state = BucketState::DELETED;
+			return;
+		}
+		_slots[hole].key = slot.key;
+		_slots[hole].state = BucketState::OCCUPIED;
+		value_ptr(slot)->~mapped_type();
+		slot.state = BucketState::EMPTY;
+		hole = index;
+	}
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+void StringKeyHashTable<T, Hash, ProbingStrategy>::clear()
+{
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_slots[i].state == BucketState::OCCUPIED)
+			value_ptr(_slots[i])->~mapped_type();
+		_slots[i].state = BucketState::EMPTY;
+	}
+	_size = 0;
+	_arena.clear();
+	_live_arena_bytes = 0;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::mapped_type&
+		StringKeyHashTable<T, Hash, ProbingStrategy>::operator[](std::string_view key)
+{
+	auto result = try_emplace(key);
+	if (result.first == end())
+	{
+		rehash(_capacity == 0 ? 16 : _capacity * 2);
+		return (*this)[key];
+	}
+	return result.first->second;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::mapped_type&
+		StringKeyHashTable<T, Hash, ProbingStrategy>::at(std::string_view key)
+{
+	size_type index = find_index(key, _hash(key));
+	if (index == _capacity)
+		throw std::out_of_range("Key not found");
+	return *value_ptr(_slots[index]);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+const typename StringKeyHashTable<T, Hash, ProbingStrategy>::mapped_type&
+		StringKeyHashTable<T, Hash, ProbingStrategy>::at(std::string_view key) const
+{
+	size_type index = find_index(key, _hash(key));
+	if (index == _capacity)
+		throw std::out_of_range("Key not found");
+	return *value_ptr(_slots[index]);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::iterator
+		StringKeyHashTable<T, Hash, ProbingStrategy>::find(std::string_view key)
+{
+	size_type index = find_index(key, _hash(key));
+	return index == _capacity ? end() : iterator(this, index);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::const_iterator
+		StringKeyHashTable<T, Hash, ProbingStrategy>::find(std::string_view key) const
+{
+	size_type index = find_index(key, _hash(key));
+	return index == _capacity ? cend() : const_iterator(this, index);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+bool StringKeyHashTable<T, Hash, ProbingStrategy>::contains(std::string_view key) const
+{
+	return find_index(key, _hash(key)) != _capacity;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type
+		StringKeyHashTable<T, Hash, ProbingStrategy>::count(std::string_view key) const
+{
+	return contains(key) ? 1 : 0;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type
+		StringKeyHashTable<T, Hash, ProbingStrategy>::size() const noexcept
+{
+	return _size;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+bool StringKeyHashTable<T, Hash, ProbingStrategy>::empty() const noexcept
+{
+	return _size == 0;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type
+		StringKeyHashTable<T, Hash, ProbingStrategy>::capacity() const noexcept
+{
+	return _capacity;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::size_type
+		StringKeyHashTable<T, Hash, ProbingStrategy>::arena_bytes() const noexcept
+{
+	return _arena.bytes_reserved();
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+float StringKeyHashTable<T, Hash, ProbingStrategy>::load_factor() const noexcept
+{
+	return _capacity == 0 ? 0.0f : static_cast<float>(_size) / static_cast<float>(_capacity);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+float StringKeyHashTable<T, Hash, ProbingStrategy>::max_load_factor() const noexcept
+{
+	return _max_load_factor;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+void StringKeyHashTable<T, Hash, ProbingStrategy>::max_load_factor(float ml)
+{
+	if (ml <= 0.0f || ml > 1.0f)
+		throw std::invalid_argument("max_load_factor must be in (0, 1]");
+	_max_load_factor = ml;
+	check_load_and_rehash();
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+void StringKeyHashTable<T, Hash, ProbingStrategy>::reserve(size_type n)
+{
+	if (n > _capacity)
+		rehash(n);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+void StringKeyHashTable<T, Hash, ProbingStrategy>::rehash(size_type new_capacity)
+{
+	// A key can miss a free slot only when its probe sequence does not cover the
+	// table; a larger table gives it more free slots to land on.
+	while (!rehash_into(new_capacity))
+		new_capacity = new_capacity == 0 ? 16 : new_capacity * 2;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+bool StringKeyHashTable<T, Hash, ProbingStrategy>::rehash_into(size_type new_capacity)
+{
+	// Keys are copied, so only values decide whether elements move; see
+	// SplitOpenAddressingHashTable::rehash_into().
+	constexpr bool move = relocate_by_move_v<InlineStringKey, T>;
+	constexpr bool move_back = std::is_nothrow_move_constructible_v<T>;
+
+	// Once dead keys outweigh live ones, copy the live spilled bytes into a fresh
+	// arena. The old slots keep pointing into the old arena until the end.
+	const bool compact = arena_needs_compaction();
+	StringArena fresh_arena;
+	std::vector<InlineStringKey> restored_keys;
+	if (compact)
+	{
+		for (size_type i = 0; i < _capacity; ++i)
+		{
+			const slot_type& slot = _slots[i];
+			if (slot.state == BucketState::OCCUPIED && !slot.key.is_inline())
+				restored_keys.emplace_back(slot.key.view(), slot.key.hash(), fresh_arena);
+		}
+	}
+
+	std::vector<size_type> placed;
+	placed.reserve(_size);
+
+	std::unique_ptr<slot_type[]> old_slots = std::move(_slots);
+	const size_type old_capacity = _capacity;
+	const size_type old_size = _size;
+
+	auto restore = [&]() noexcept {
+		size_type next = 0;
+		for (size_type i = 0; i < old_capacity && next < placed.size(); ++i)
+		{
+			if (old_slots[i].state != BucketState::OCCUPIED)
+				continue;
+			mapped_type* value = value_ptr(_slots[placed[next++]]);
+			if constexpr (move_back)
+			{
+				value_ptr(old_slots[i])->~mapped_type();
+				new (&old_slots[i].value) mapped_type(std::move(*value));
+			}
+			value->~mapped_type();
+		}
+		_slots = std::move(old_slots);
+		_capacity = old_capacity;
+		_size = old_size;
+		if (_probing)
+			_probing->set_capacity(old_capacity);
+	};
+
+	try
+	{
+		allocate_slots(new_capacity);
+		_size = 0;
+
+		// Keys carry their hash, so slots move without rehashing; spilled bytes are
+		// copied only when compacting.
+		size_type restored = 0;
+		for (size_type i = 0; i < old_capacity; ++i)
+		{
+			slot_type& old_slot = old_slots[i];
+			if (old_slot.state != BucketState::OCCUPIED)
+				continue;
+
+			const InlineStringKey& stored = compact && !old_slot.key.is_inline() ? restored_keys[restored++] : old_slot.key;
+			auto [index, inserted] = probe_insert_slot(old_slot.key.view(), old_slot.key.hash());
+			if (!inserted)
+			{
+				restore();
+				return false;
+			}
+
+			slot_type& slot = _slots[index];
+			new (&slot.value) mapped_type(relocation_source<move>(*value_ptr(old_slot)));
+			slot.key = stored;
+			slot.state = BucketState::OCCUPIED;
+			placed.push_back(index);
+			++_size;
+		}
+	}
+	catch (...)
+	{
+		restore();
+		throw;
+	}
+
+	for (size_type i = 0; i < old_capacity; ++i)
+	{
+		if (old_slots[i].state == BucketState::OCCUPIED)
+			value_ptr(old_slots[i])->~mapped_type();
+	}
+	if (compact)
+		_arena = std::move(fresh_arena);
+	return true;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+MemoryUsage StringKeyHashTable<T, Hash, ProbingStrategy>::memory_usage() const
+{
+	return memory_usage([](std::string_view, const mapped_type&) { return size_type(0); });
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+template<typename Sizer>
+MemoryUsage StringKeyHashTable<T, Hash, ProbingStrategy>::memory_usage(Sizer sizer) const
+{
+	MemoryUsage usage;
+	usage.object_bytes = sizeof(*this);
+	usage.slot_bytes = _capacity * (sizeof(InlineStringKey) + sizeof(mapped_type));
+	usage.metadata_bytes = _capacity * sizeof(slot_type) - usage.slot_bytes;
+	usage.probing_bytes = _probing ? sizeof(ProbingStrategy) : 0;
+
+	size_type value_heap = 0;
+	for (size_type i = 0; i < _capacity; ++i)
+	{
+		if (_slots[i].state == BucketState::OCCUPIED)
+			value_heap += sizer(_slots[i].key.view(), *value_ptr(_slots[i]));
+	}
+	usage.external_bytes = _arena.bytes_reserved() + value_heap;
+	usage.payload_bytes = _size * (sizeof(InlineStringKey) + sizeof(mapped_type)) + _live_arena_bytes + value_heap;
+	return usage;
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::iterator StringKeyHashTable<T, Hash, ProbingStrategy>::begin()
+{
+	return iterator(this, 0);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::iterator StringKeyHashTable<T, Hash, ProbingStrategy>::end()
+{
+	return iterator(this, _capacity);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::const_iterator StringKeyHashTable<T, Hash, ProbingStrategy>::begin() const
+{
+	return const_iterator(this, 0);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::const_iterator StringKeyHashTable<T, Hash, ProbingStrategy>::end() const
+{
+	return const_iterator(this, _capacity);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::const_iterator StringKeyHashTable<T, Hash, ProbingStrategy>::cbegin() const
+{
+	return const_iterator(this, 0);
+}
+
+template<typename T, typename Hash, typename ProbingStrategy>
+typename StringKeyHashTable<T, Hash, ProbingStrategy>::const_iterator StringKeyHashTable<T, Hash, ProbingStrategy>::cend() const
+{
+	return const_iterator(this, _capacity);
+}
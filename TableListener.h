@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+struct RehashEvent
+{
+	std::size_t old_capacity = 0;
+	std::size_t new_capacity = 0;
+	// Elements before the rehash in on_rehash_begin, after it in on_rehash_end.
+	std::size_t size = 0;
+	// Deleted markers dropped by the rehash; known only in on_rehash_end.
+	std::size_t tombstones_purged = 0;
+	// Wall time of the rehash; known only in on_rehash_end.
+	std::chrono::nanoseconds duration{ 0 };
+};
+
+struct InsertFailureEvent
+{
+	std::size_t capacity = 0;
+	std::size_t size = 0;
+	// The element was being moved by a rehash and has been dropped, rather than
+	// being a new insertion the caller sees fail.
+	bool during_rehash = false;
+};
+
+// Observer for table growth. Callbacks run synchronously on the thread doing the
+// insertion, inside the table operation, so they must not touch the table.
+class ITableListener
+{
+public:
+	virtual ~ITableListener() = default;
+
+	virtual void on_rehash_begin(const RehashEvent& /*event*/) {}
+	virtual void on_rehash_end(const RehashEvent& /*event*/) {}
+	virtual void on_insert_failure(const InsertFailureEvent& /*event*/) {}
+};
@@ -0,0 +1,519 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <utility>
+#include <optional>
+#include <stdexcept>
+#include <filesystem>
+#include <functional>
+#include <type_traits>
+
+#include "LinearProbing.h"
+#include "OpenAddressingHashTable.h"
+
+// Map that stays within a RAM budget by spilling to local files. Keys are split
+// by the top bits of a mixed hash into independent OpenAddressingHashTable
+// partitions. When resident partitions exceed the budget, the least recently used
+// ones are written to the spill directory and freed; touching a spilled partition
+// reads it back in, possibly spilling another. Oversized aggregations then run at
+// disk speed instead of running out of memory.
+//
+// Spill files hold raw key and value bytes, so keys and values must be trivially
+// copyable; the files are private to this process and removed when read back or
+// when the table is destroyed. Not thread-safe.
+template<
+	typename Key,
+	typename T,
+	typename Hash = std::hash<Key>,
+	typename KeyEqual = std::equal_to<Key>,
+	typename ProbingStrategy = LinearProbing<Key>
+>
+class TieredHashTable
+{
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using size_type = std::size_t;
+	using table_type = OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>;
+
+	static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<T>,
+		"TieredHashTable spills raw bytes and needs trivially copyable keys and values");
+
+private:
+	struct Partition
+	{
+		std::unique_ptr<table_type> table;
+		size_type size = 0;
+		size_type bytes = 0;
+		size_type accounted_capacity = 0;
+		std::uint64_t last_use = 0;
+		bool spilled = false;
+	};
+
+	static constexpr char spill_magic[6] = { 'O', 'A', 'H', 'T', 'S', 'P' };
+	static constexpr std::uint16_t spill_version = 1;
+	static constexpr size_type partition_capacity = 16;
+
+	std::vector<Partition> _partitions;
+	unsigned _partition_bits;
+	size_type _memory_budget;
+	size_type _resident_bytes = 0;
+	size_type _size = 0;
+	std::uint64_t _clock = 0;
+	size_type _spills = 0;
+	size_type _faults = 0;
+
+	std::filesystem::path _spill_directory;
+	std::string _spill_prefix;
+	hasher _hash;
+
+public:
+	// partition_bits sets 2^partition_bits partitions; more partitions spill in
+	// smaller pieces.
+	explicit TieredHashTable(size_type memory_budget, const std::filesystem::path& spill_directory = std::filesystem::temp_directory_path(), unsigned partition_bits = 6);
+
+	TieredHashTable(const TieredHashTable&) = delete;
+	TieredHashTable& operator=(const TieredHashTable&) = delete;
+	~TieredHashTable();
+
+	bool insert(const key_type& key, const mapped_type& value);
+	bool insert_or_assign(const key_type& key, const mapped_type& value);
+
+	// Stores init for a new key, otherwise applies combine(mapped_type&) to the
+	// stored value. Returns the value now stored.
+	template<typename Combine>
+	mapped_type upsert(const key_type& key, const mapped_type& init, Combine&& combine);
+
+	// Lookups are non-const because they may read a partition back from disk.
+	std::optional<mapped_type> find(const key_type& key);
+	bool contains(const key_type& key);
+	size_type erase(const key_type& key);
+	void clear();
+
+	// Calls fn(const key_type&, const mapped_type&) for every element, one
+	// partition at a time, so at most one spilled partition is read per step.
+	template<typename Fn>
+	void for_each(Fn&& fn);
+
+	size_type size() const noexcept;
+	bool empty() const noexcept;
+
+	size_type memory_budget() const noexcept;
+	void memory_budget(size_type bytes);
+	size_type resident_bytes() const noexcept;
+	size_type partition_count() const noexcept;
+	size_type spilled_partitions() const noexcept;
+
+	// Partitions written out and read back since construction.
+	size_type spills() const noexcept;
+	size_type faults() const noexcept;
+
+private:
+	size_type partition_index(const key_type& key) const noexcept;
+	std::filesystem::path spill_path(size_type index) const;
+
+	// Makes partition index resident and returns its table.
+	table_type& acquire(size_type index);
+	// Refreshes the partition's accounted bytes and spills others until the
+	// resident set fits the budget; index itself is never spilled. An index of
+	// partition_count() only enforces the budget.
+	void settle(size_type index);
+	void spill(size_type index);
+	void fault_in(size_type index);
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>
+		::TieredHashTable(size_type memory_budget, const std::filesystem::path& spill_directory, unsigned partition_bits)
+	: _partitions(size_type(1) << (partition_bits > 16 ? 16 : partition_bits))
+	, _partition_bits(partition_bits > 16 ? 16 : partition_bits)
+	, _memory_budget(memory_budget)
+	, _spill_directory(spill_directory)
+	, _hash(Hash())
+{
+	// Several tables may share a directory, so each gets its own file prefix.
+	static std::atomic<std::uint64_t> instances{ 0 };
+	char prefix[64];
+	std::snprintf(prefix, sizeof(prefix), "oaht-spill-%llx-%llx-",
+		static_cast<unsigned long long>(reinterpret_cast<std::uintptr_t>(this)),
+		static_cast<unsigned long long>(instances.fetch_add(1, std::memory_order_relaxed)));
+	_spill_prefix = prefix;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::~TieredHashTable()
+{
+	for (size_type i = 0; i < _partitions.size(); ++i)
+	{
+		if (_partitions[i].spilled)
+		{
+			std::error_code ignored;
+			std::filesystem::remove(spill_path(i), ignored);
+		}
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::partition_index(const key_type& key) const noexcept
+{
+	if (_partition_bits == 0)
+		return 0;
+	// Partition tables index by the low bits of the same hash; the top bits of a
+	// mixed value keep the two independent.
+	const std::uint64_t mixed = static_cast<std::uint64_t>(_hash(key)) * 0x9E3779B97F4A7C15ull;
+	return static_cast<size_type>(mixed >> (64 - _partition_bits));
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline std::filesystem::path TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::spill_path(size_type index) const
+{
+	return _spill_directory / (_spill_prefix + std::to_string(index) + ".bin");
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::table_type&
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::acquire(size_type index)
+{
+	Partition& partition = _partitions[index];
+	partition.last_use = ++_clock;
+	if (!partition.table)
+	{
+		if (partition.spilled)
+			fault_in(index);
+		else
+			partition.table.reset(new table_type(partition_capacity));
+		settle(index);
+	}
+	return *partition.table;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::settle(size_type index)
+{
+	// Element bytes live in the slots, so usage only changes with capacity.
+	Partition* partition = index < _partitions.size() ? &_partitions[index] : nullptr;
+	if (partition && partition->table && partition->table->capacity() != partition->accounted_capacity)
+	{
+		_resident_bytes -= partition->bytes;
+		partition->bytes = partition->table->memory_usage().total();
+		partition->accounted_capacity = partition->table->capacity();
+		_resident_bytes += partition->bytes;
+	}
+
+	while (_resident_bytes > _memory_budget)
+	{
+		size_type victim = _partitions.size();
+		for (size_type i = 0; i < _partitions.size(); ++i)
+		{
+			if (i != index && _partitions[i].table
+				&& (victim == _partitions.size() || _partitions[i].last_use < _partitions[victim].last_use))
+				victim = i;
+		}
+		if (victim == _partitions.size())
+			break;
+		spill(victim);
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::spill(size_type index)
+{
+	Partition& partition = _partitions[index];
+	if (partition.size != 0)
+	{
+		const std::filesystem::path path = spill_path(index);
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Cannot open spill file for writing: " + path.string());
+
+		unsigned char header[16] = {};
+		std::memcpy(header, spill_magic, sizeof(spill_magic));
+		header[6] = static_cast<unsigned char>(spill_version & 0xFF);
+		header[7] = static_cast<unsigned char>(spill_version >> 8);
+		const std::uint64_t count = partition.size;
+		std::memcpy(header + 8, &count, sizeof(count));
+		out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+		unsigned char record[sizeof(Key) + sizeof(T)];
+		for (const auto& [key, value] : *partition.table)
+		{
+			std::memcpy(record, &key, sizeof(Key));
+			std::memcpy(record + sizeof(Key), &value, sizeof(T));
+			out.write(reinterpret_cast<const char*>(record), sizeof(record));
+		}
+		out.close();
+		if (!out)
+		{
+			std::error_code ignored;
+			std::filesystem::remove(path, ignored);
+			throw std::runtime_error("Cannot write spill file: " + path.string());
+		}
+		partition.spilled = true;
+	}
+
+	_resident_bytes -= partition.bytes;
+	partition.bytes = 0;
+	partition.accounted_capacity = 0;
+	partition.table.reset();
+	++_spills;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::fault_in(size_type index)
+{
+	Partition& partition = _partitions[index];
+	const std::filesystem::path path = spill_path(index);
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		throw std::runtime_error("Cannot open spill file: " + path.string());
+
+	unsigned char header[16];
+	if (!in.read(reinterpret_cast<char*>(header), sizeof(header))
+		|| std::memcmp(header, spill_magic, sizeof(spill_magic)) != 0
+		|| static_cast<std::uint16_t>(header[6] | (header[7] << 8)) != spill_version)
+		throw std::runtime_error("Not a spill file: " + path.string());
+
+	std::uint64_t count = 0;
+	std::memcpy(&count, header + 8, sizeof(count));
+	if (count != partition.size)
+		throw std::runtime_error("Spill file does not match its partition: " + path.string());
+
+	std::unique_ptr<table_type> table(new table_type(partition_capacity));
+	table->reserve(static_cast<size_type>(static_cast<float>(count) / table->max_load_factor()) + 1);
+
+	unsigned char record[sizeof(Key) + sizeof(T)];
+	Key key;
+	T value;
+	for (std::uint64_t i = 0; i < count; ++i)
+	{
+		if (!in.read(reinterpret_cast<char*>(record), sizeof(record)))
+			throw std::runtime_error("Truncated spill file: " + path.string());
+		std::memcpy(&key, record, sizeof(Key));
+		std::memcpy(&value, record + sizeof(Key), sizeof(T));
+		if (table->insert(key, value).first == table->end())
+			throw std::length_error("TieredHashTable partition has no free slot");
+	}
+	in.close();
+
+	partition.table = std::move(table);
+	partition.spilled = false;
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+	++_faults;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert(const key_type& key, const mapped_type& value)
+{
+	const size_type index = partition_index(key);
+	table_type& table = acquire(index);
+	auto [it, inserted] = table.insert(key, value);
+	if (it == table.end())
+	{
+		table.rehash(table.capacity() * 2);
+		std::tie(it, inserted) = table.insert(key, value);
+		if (it == table.end())
+			throw std::length_error("TieredHashTable partition has no free slot");
+	}
+	if (inserted)
+	{
+		++_partitions[index].size;
+		++_size;
+	}
+	settle(index);
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::insert_or_assign(const key_type& key, const mapped_type& value)
+{
+	const size_type index = partition_index(key);
+	table_type& table = acquire(index);
+	auto [it, inserted] = table.insert_or_assign(key, value);
+	if (it == table.end())
+	{
+		table.rehash(table.capacity() * 2);
+		std::tie(it, inserted) = table.insert_or_assign(key, value);
+		if (it == table.end())
+			throw std::length_error("TieredHashTable partition has no free slot");
+	}
+	if (inserted)
+	{
+		++_partitions[index].size;
+		++_size;
+	}
+	settle(index);
+	return inserted;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Combine>
+typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::upsert(const key_type& key, const mapped_type& init, Combine&& combine)
+{
+	const size_type index = partition_index(key);
+	table_type& table = acquire(index);
+	auto [it, inserted] = table.insert(key, init);
+	if (it == table.end())
+	{
+		table.rehash(table.capacity() * 2);
+		std::tie(it, inserted) = table.insert(key, init);
+		if (it == table.end())
+			throw std::length_error("TieredHashTable partition has no free slot");
+	}
+	if (inserted)
+	{
+		++_partitions[index].size;
+		++_size;
+	}
+	else
+		combine(it->second);
+
+	// settle() never spills this partition, but copy first anyway: the result
+	// must not depend on the iterator staying valid.
+	const mapped_type result = it->second;
+	settle(index);
+	return result;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+std::optional<typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::mapped_type>
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::find(const key_type& key)
+{
+	const size_type index = partition_index(key);
+	if (_partitions[index].size == 0)
+		return std::nullopt;
+
+	table_type& table = acquire(index);
+	auto it = table.find(key);
+	if (it == table.end())
+		return std::nullopt;
+	return it->second;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+bool TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::contains(const key_type& key)
+{
+	const size_type index = partition_index(key);
+	return _partitions[index].size != 0 && acquire(index).contains(key);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::erase(const key_type& key)
+{
+	const size_type index = partition_index(key);
+	if (_partitions[index].size == 0)
+		return 0;
+
+	const size_type erased = acquire(index).erase(key);
+	_partitions[index].size -= erased;
+	_size -= erased;
+	return erased;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::clear()
+{
+	for (size_type i = 0; i < _partitions.size(); ++i)
+	{
+		Partition& partition = _partitions[i];
+		if (partition.spilled)
+		{
+			std::error_code ignored;
+			std::filesystem::remove(spill_path(i), ignored);
+		}
+		partition = Partition();
+	}
+	_resident_bytes = 0;
+	_size = 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+template<typename Fn>
+void TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::for_each(Fn&& fn)
+{
+	for (size_type i = 0; i < _partitions.size(); ++i)
+	{
+		if (_partitions[i].size == 0)
+			continue;
+		for (const auto& [key, value] : acquire(i))
+			fn(key, value);
+	}
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size() const noexcept
+{
+	return _size;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline bool TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::empty() const noexcept
+{
+	return _size == 0;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_budget() const noexcept
+{
+	return _memory_budget;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+void TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::memory_budget(size_type bytes)
+{
+	_memory_budget = bytes;
+	settle(_partitions.size());
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::resident_bytes() const noexcept
+{
+	return _resident_bytes;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::partition_count() const noexcept
+{
+	return _partitions.size();
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::spilled_partitions() const noexcept
+{
+	size_type count = 0;
+	for (const Partition& partition : _partitions)
+		count += partition.spilled ? 1 : 0;
+	return count;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::spills() const noexcept
+{
+	return _spills;
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+inline typename TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::size_type
+		TieredHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>::faults() const noexcept
+{
+	return _faults;
+}
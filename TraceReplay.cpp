@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "OperationTrace.h"
+#include "ProbeStatistics.h"
+#include "OpenAddressingHashTable.h"
+#include "SplitOpenAddressingHashTable.h"
+#include "LinearProbing.h"
+#include "QuadraticProbing.h"
+#include "DoubleHashing.h"
+#include "TriangularProbing.h"
+
+// Replays a recorded trace against a grid of table configurations. Recorded key
+// hashes stand in for the keys, so every configuration sees the same access
+// pattern and the same key identities as the captured traffic.
+
+namespace
+{
+    using replay_key = std::uint64_t;
+    using replay_value = std::uint64_t;
+
+    struct ReplayResult
+    {
+        double seconds = 0.0;
+        std::size_t hits = 0;
+        ProbeStatistics probes;
+    };
+
+    template<typename Table>
+    void apply(Table& table, const TraceRecord& record, std::size_t& hits)
+    {
+        switch (record.operation)
+        {
+        case TraceOperation::INSERT:
+            hits += table.insert(record.key_hash, record.key_hash).second ? 0 : 1;
+            break;
+        case TraceOperation::FIND:
+            hits += table.find(record.key_hash) != table.end() ? 1 : 0;
+            break;
+        case TraceOperation::ERASE:
+            hits += table.erase(record.key_hash);
+            break;
+        case TraceOperation::SUBSCRIPT:
+            ++table[record.key_hash];
+            break;
+        }
+    }
+
+    template<template<typename...> class TableTemplate, typename Strategy>
+    ReplayResult replay(const std::vector<TraceRecord>& trace, float max_load_factor)
+    {
+        using counting_strategy = CountingProbing<replay_key, Strategy>;
+        using table_type = TableTemplate<replay_key, replay_value, std::hash<replay_key>, std::equal_to<replay_key>, counting_strategy>;
+
+        ReplayResult result;
+        table_type table(16, std::hash<replay_key>(), std::equal_to<replay_key>(), counting_strategy(result.probes));
+        table.max_load_factor(max_load_factor);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const TraceRecord& record : trace)
+            apply(table, record, result.hits);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    void report(const std::string& name, float max_load_factor, std::size_t operations, const ReplayResult& result)
+    {
+        const double mops = result.seconds > 0.0 ? static_cast<double>(operations) / result.seconds / 1e6 : 0.0;
+        std::cout << std::left << std::setw(32) << name
+                  << std::right << std::setw(6) << std::fixed << std::setprecision(2) << max_load_factor
+                  << std::setw(12) << mops
+                  << std::setw(12) << result.probes.average_probe_length()
+                  << std::setw(10) << result.probes.max_probe_length
+                  << std::setw(12) << result.hits << '\n';
+    }
+
+    template<template<typename...> class TableTemplate, typename Strategy>
+    void run(const std::string& name, const std::vector<TraceRecord>& trace)
+    {
+        for (float max_load_factor : { 0.5f, 0.75f, 0.9f })
+            report(name, max_load_factor, trace.size(), replay<TableTemplate, Strategy>(trace, max_load_factor));
+    }
+
+    // Adapters with the five-parameter shape shared by both layouts.
+    template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+    using Interleaved = OpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>;
+
+    template<typename Key, typename T, typename Hash, typename KeyEqual, typename ProbingStrategy>
+    using Split = SplitOpenAddressingHashTable<Key, T, Hash, KeyEqual, ProbingStrategy>;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace-file>\n";
+        return 2;
+    }
+
+    std::vector<TraceRecord> trace;
+    try
+    {
+        trace = read_trace(argv[1]);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    std::cout << "Replaying " << trace.size() << " operations\n";
+    std::cout << std::left << std::setw(32) << "configuration"
+              << std::right << std::setw(6) << "mlf"
+              << std::setw(12) << "Mops/s"
+              << std::setw(12) << "avg probes"
+              << std::setw(10) << "max"
+              << std::setw(12) << "hits" << '\n';
+
+    run<Interleaved, LinearProbing<replay_key>>("interleaved/linear", trace);
+    run<Interleaved, QuadraticProbing<replay_key>>("interleaved/quadratic", trace);
+    run<Interleaved, DoubleHashing<replay_key>>("interleaved/double", trace);
+    run<Interleaved, TriangularProbing<replay_key>>("interleaved/triangular", trace);
+    run<Split, LinearProbing<replay_key>>("split/linear", trace);
+    run<Split, QuadraticProbing<replay_key>>("split/quadratic", trace);
+    run<Split, DoubleHashing<replay_key>>("split/double", trace);
+    run<Split, TriangularProbing<replay_key>>("split/triangular", trace);
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ProbingStrategy.h"
+#include "FastModulo.h"
+
+// Quadratic probing with triangular offsets hash + i*(i+1)/2. Over a power of two
+// capacity the sequence visits every slot exactly once, so the table never reports
+// a full table while free slots remain; adjust_capacity() keeps it power of two.
+template<typename Key>
+class TriangularProbing : public IProbingStrategy<Key>
+{
+private:
+	FastModulo _modulo;
+
+public:
+	std::size_t probe(const Key& /*key*/, std::size_t hash, std::size_t attempt, std::size_t capacity) const override
+	{
+		return _modulo.reduce(hash + attempt * (attempt + 1) / 2, capacity);
+	}
+
+	std::size_t next(const Key& /*key*/, std::size_t /*hash*/, std::size_t attempt, std::size_t previous, std::size_t capacity) const override
+	{
+		return _modulo.reduce(previous + attempt, capacity);
+	}
+
+	std::size_t adjust_capacity(std::size_t capacity) const override
+	{
+		if (capacity == 0)
+			return 0;
+
+		std::size_t rounded = 1;
+		while (rounded < capacity)
+			rounded <<= 1;
+		return rounded;
+	}
+
+	void set_capacity(std::size_t capacity) override
+	{
+		_modulo = FastModulo(capacity);
+	}
+
+	IProbingStrategy<Key>* clone() const override
+	{
+		return new TriangularProbing<Key>(*this);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+// Slab of values addressed by 32-bit index. Chunks are never reallocated, so a
+// value keeps its address until it is destroyed; freed indices are reused.
+template<typename T>
+class ValuePool
+{
+public:
+	using size_type = std::size_t;
+	using index_type = std::uint32_t;
+
+	static constexpr size_type chunk_size = 256;
+
+private:
+	struct value_storage
+	{
+		alignas(T) unsigned char bytes[sizeof(T)];
+	};
+
+	std::vector<std::unique_ptr<value_storage[]>> _chunks;
+	std::vector<bool> _live;
+	std::vector<index_type> _free;
+	size_type _size = 0;
+
+	value_storage& slot(index_type index) const noexcept
+	{
+		return _chunks[index / chunk_size][index % chunk_size];
+	}
+
+	index_type acquire_index()
+	{
+		if (!_free.empty())
+		{
+			index_type index = _free.back();
+			_free.pop_back();
+			return index;
+		}
+
+		if (_live.size() > static_cast<size_type>(UINT32_MAX))
+			throw std::length_error("ValuePool index space exhausted");
+
+		index_type index = static_cast<index_type>(_live.size());
+		if (index % chunk_size == 0)
+			_chunks.emplace_back(new value_storage[chunk_size]);
+		_live.push_back(false);
+		return index;
+	}
+
+public:
+	ValuePool() = default;
+	ValuePool(const ValuePool&) = delete;
+	ValuePool& operator=(const ValuePool&) = delete;
+
+	ValuePool(ValuePool&& other) noexcept
+		: _chunks(std::move(other._chunks))
+		, _live(std::move(other._live))
+		, _free(std::move(other._free))
+		, _size(other._size)
+	{
+		other._size = 0;
+	}
+
+	ValuePool& operator=(ValuePool&& other) noexcept
+	{
+		if (this != &other)
+		{
+			clear();
+			_chunks = std::move(other._chunks);
+			_live = std::move(other._live);
+			_free = std::move(other._free);
+			_size = other._size;
+			other._size = 0;
+		}
+		return *this;
+	}
+
+	~ValuePool()
+	{
+		clear();
+	}
+
+	template<typename... Args>
+	index_type emplace(Args&&... args)
+	{
+		index_type index = acquire_index();
+		try
+		{
+			new (&slot(index)) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			_free.push_back(index);
+			throw;
+		}
+		_live[index] = true;
+		++_size;
+		return index;
+	}
+
+	void destroy(index_type index) noexcept
+	{
+		(*this)[index].~T();
+		_live[index] = false;
+		_free.push_back(index);
+		--_size;
+	}
+
+	void clear() noexcept
+	{
+		for (size_type i = 0; i < _live.size(); ++i)
+		{
+			if (_live[i])
+				(*this)[static_cast<index_type>(i)].~T();
+		}
+		_chunks.clear();
+		_live.clear();
+		_free.clear();
+		_size = 0;
+	}
+
+	T& operator[](index_type index) noexcept
+	{
+		return *std::launder(reinterpret_cast<T*>(&slot(index)));
+	}
+
+	const T& operator[](index_type index) const noexcept
+	{
+		return *std::launder(reinterpret_cast<const T*>(&slot(index)));
+	}
+
+	[[nodiscard]] size_type size() const noexcept { return _size; }
+	[[nodiscard]] size_type chunk_count() const noexcept { return _chunks.size(); }
+
+	// Value storage across all chunks, live or free.
+	[[nodiscard]] size_type slot_bytes() const noexcept { return _chunks.size() * chunk_size * sizeof(value_storage); }
+
+	// Chunk pointers, live bits and the free list.
+	[[nodiscard]] size_type metadata_bytes() const noexcept
+	{
+		return _chunks.capacity() * sizeof(std::unique_ptr<value_storage[]>) + _live.capacity() / 8 + _free.capacity() * sizeof(index_type);
+	}
+};